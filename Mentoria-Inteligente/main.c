@@ -4,9 +4,25 @@
 #include <locale.h>
 #include <wchar.h>
 #include <wctype.h>
+#include <ctype.h>
 #include <termios.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
 #include <limits.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <math.h>
+#include <stdarg.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include <curl/curl.h>
 #include <cjson/cJSON.h>
 
@@ -16,6 +32,49 @@
 #define ARQ_MENTORES "mentores.txt"
 #define ARQ_MENTORADOS "mentorados.txt"
 #define ARQ_PROMPT "prompt.txt"
+#define ARQ_LOG_MENTORES "mentores.log"
+#define ARQ_LOG_MENTORADOS "mentorados.log"
+#define ARQ_TRAVA_MENTORES "mentores.lock"
+#define ARQ_TRAVA_MENTORADOS "mentorados.lock"
+#define ARQ_CACHE "cache_respostas.bin"
+#define ARQ_TRAVA_CACHE "cache_respostas.lock"
+#define ARQ_RELATORIO "relatorio_mentoria.txt"
+#define ARQ_METRICAS "metricas_gemini.log"
+#define ARQ_ATRIBUICAO "atribuicao_mentoria.txt"
+#define ARQ_RESULTADOS "resultados_mentoria.log"
+#define ARQ_TRAVA_RESULTADOS "resultados_mentoria.lock"
+#define CACHE_ASSINATURA "MCR2"
+#define TAM_CABECALHO_CACHE 28  // assinatura + modelo + seq + geração
+#define MAX_TOKENS 32
+#define TAM_TOKEN 32
+#define TOP_K_MENTORES 10      // candidatos enviados ao modelo
+#define PESO_EXPERIENCIA 0.5   // bônus máximo por experiência (atingido com 30 anos)
+#define PESO_EXPERIENCIA_SIMILARIDADE 0.1  // idem, na escala do cosseno (0 a 1)
+#define VAGAS_PADRAO 3         // mentorados por mentor sem 'vagas' próprio (atribuição global)
+#define AREAS_ATRIBUICAO 20   // áreas com termos em comum ligadas a cada mentorado na atribuição global
+#define DIM_VETOR 128          // dimensões dos vetores de área/objetivo (potência de 2, múltiplo de 16)
+#define CONCORRENCIA_PADRAO 8  // requisições simultâneas na combinação em lote
+#define CONCORRENCIA_MAXIMA 64
+#define MAX_RECOMENDADOS 3      // mentores por recomendação estruturada ou resultado no histórico
+#define MENTORADOS_POR_REQUISICAO 10  // combinação em lote: mentorados por prompt (1 = um por requisição)
+#define MAX_MENTORADOS_POR_REQUISICAO 25
+#define REQUISICOES_POR_MINUTO 60   // limite do cliente (GEMINI_RPM no ambiente; 0 desativa)
+#define RAJADA_MAXIMA 4             // requisições que podem sair juntas após um período ocioso
+#define MAX_TENTATIVAS 5            // envios por requisição em 429/5xx/falhas de rede
+#define ATRASO_BASE_MS 500          // espera da 1ª nova tentativa, dobrada a cada falha
+#define ATRASO_MAXIMO_MS 30000
+#define INTERVALO_CONSULTAS_MS 200  // atualização do progresso das consultas em segundo plano
+#define TECLA_ATUALIZAR 0           // capturaTecla: nenhuma tecla, mas a tela deve ser redesenhada
+#define TECLA_PAGINA_ACIMA 0x101    // códigos acima de 255: teclas especiais
+#define TECLA_PAGINA_ABAIXO 0x102
+#define TECLA_INICIO 0x103
+#define TECLA_FIM 0x104
+#define TECLA_ACIMA 0x105           // setas: lerTecla as converte em W/S/A/D
+#define TECLA_ABAIXO 0x106
+#define TECLA_ESQUERDA 0x107
+#define TECLA_DIREITA 0x108
+#define LIMITE_LOG_COMPACTACAO 1024  // entradas no log antes de considerar compactar
+#define PROFUNDIDADE_JSON 16    // níveis rastreados pelo extrator de respostas
 #define GEMINI_API_KEY "API_KEY"  // Adicione sua chave de API do Gemini aqui
 #define GEMINI_URL "https://generativelanguage.googleapis.com/v1beta/models/gemini-2.5-pro:generateContent?key=" GEMINI_API_KEY
 
@@ -25,17 +84,393 @@ typedef struct {
     char nome[100];
     char area[100];
     int experiencia;
+    int vagas;  // mentorados que aceita na atribuição global (0 = valor padrão)
 } Mentor;
 
+// Recomendação no modo estruturado (GEMINI_ESTRUTURADO): mentores escolhidos
+// pelo modelo entre os candidatos, já validados e ordenados pela nota
+typedef struct {
+    int mentor;          // posição em mentores.txt (número da lista - 1)
+    double pontuacao;    // nota do modelo, de 0 a 10
+    char nome[100];
+    char motivo[160];
+} MentorRecomendado;
+
+typedef struct {
+    uint64_t entrada;    // hash das entradas (ver entradaDoMentorado): se não mudou, a recomendação ainda vale
+    int total;
+    MentorRecomendado itens[MAX_RECOMENDADOS];
+} RecomendacaoEstruturada;
+
 typedef struct {
     char nome[100];
     char objetivo[200];
+    RecomendacaoEstruturada *recomendacao;  // última recomendação estruturada (NULL = nenhuma)
 } Mentorado;
 
-struct MemoryStruct {
-    char *memory;
-    size_t size;
-};
+// Texto com tamanho e capacidade conhecidos: anexar custa O(n) no total,
+// sem strlen sobre o que já foi escrito (ao contrário de strncat)
+typedef struct {
+    char *dados;
+    size_t tamanho;
+    size_t capacidade;
+} TextoDinamico;
+
+// Extrator incremental de candidates[0].content.parts[0].text: percorre o
+// JSON byte a byte conforme chega, guardando só o caminho atual e o texto
+// procurado (já sem escapes), sem montar a árvore do documento
+typedef struct {
+    char tipo;            // '{' ou '['
+    int indice;           // posição atual (arrays)
+    int esperando_chave;  // objetos: próxima string é uma chave
+    char chave[16];       // chave atual (objetos)
+} NivelJson;
+
+typedef struct {
+    NivelJson pilha[PROFUNDIDADE_JSON];
+    int profundidade;     // pode passar de PROFUNDIDADE_JSON; níveis extras não são rastreados
+    int estado;           // EXTRATOR_FORA, EXTRATOR_STRING, ...
+    int eh_chave;
+    int tam_chave;
+    int capturando;       // a string atual é o campo procurado
+    int encontrado;
+    unsigned codigo;      // \uXXXX em leitura
+    int digitos;
+    unsigned surrogate;   // metade alta de um par UTF-16 aguardando a baixa
+    TextoDinamico texto;
+} ExtratorTexto;
+
+// Corpo de uma resposta não-streaming: bytes brutos (para diagnóstico de
+// erros) e o texto extraído enquanto os bytes chegam
+typedef struct {
+    CURL *curl;
+    int preparada;        // capacidade já reservada pelo Content-Length
+    TextoDinamico bruto;
+    ExtratorTexto extrator;
+    double tempo_interpretacao_ms;  // gasto no extrator enquanto os bytes chegam
+} RespostaGemini;
+
+// Trechos de prompt.txt, lidos e separados uma única vez ao iniciar.
+// Marcadores aceitos no arquivo: {mentorado}, {objetivo} e {mentores}.
+typedef enum { TRECHO_LITERAL, TRECHO_MENTORADO, TRECHO_OBJETIVO, TRECHO_MENTORES } TipoTrecho;
+
+typedef struct {
+    TipoTrecho tipo;
+    const char *texto;  // aponta para ModeloPrompt.fonte (só literais)
+    size_t tamanho;
+} TrechoPrompt;
+
+typedef struct {
+    char *fonte;
+    TrechoPrompt *trechos;
+    int total;
+    size_t tamanho_literais;  // soma dos literais, usada para reservar espaço
+} ModeloPrompt;
+
+// Índice de mentores por área normalizada (sem acentos e sem distinção de
+// maiúsculas): tabela hash com endereçamento aberto, área -> ids na lista
+typedef struct {
+    char *chave;     // NULL = posição livre
+    int *ids;
+    int total;       // inclui ids removidos (tombstones) até a compactação
+    int ativos;      // pode ser 0 depois de remoções; a chave é mantida
+    int capacidade;
+    int linha;       // vetor da área em vetores_areas (-1 = ainda não calculado)
+} GrupoArea;
+
+typedef struct {
+    GrupoArea *grupos;
+    int capacidade;  // potência de 2
+    int usados;
+    int total_ids;   // mentores indexados; difere de totalMentores se o índice estiver desatualizado
+} IndiceAreas;
+
+// Vetores (normalizados) das áreas do índice, uma linha contígua por área,
+// alinhados a 32 bytes para os kernels SIMD. Mentores da mesma área
+// compartilham a linha.
+typedef struct {
+    float *dados;
+    int linhas;
+    int capacidade;
+} MatrizVetores;
+
+// Índice de prefixos de uma tela de lista: as palavras normalizadas de cada
+// item (nome, área ou objetivo), ordenadas, com a posição do item na lista.
+// Um prefixo corresponde a uma faixa contígua de entradas.
+typedef struct {
+    uint32_t palavra;  // deslocamento em IndicePrefixos.texto
+    int posicao;
+} EntradaPrefixo;
+
+typedef struct {
+    TextoDinamico texto;
+    EntradaPrefixo *entradas;
+    int total;
+    int capacidade;
+} IndicePrefixos;
+
+// Filtro digitado: um termo por palavra e a faixa de cada um no índice
+typedef struct {
+    char termos[MAX_TOKENS][TAM_TOKEN];
+    int inicio[MAX_TOKENS];
+    int fim[MAX_TOKENS];
+    int total;
+} FiltroLista;
+
+// Persistência incremental de uma lista (mentores ou mentorados): o .txt é
+// um snapshot e cada alteração posterior vira uma linha no .log. Remoções
+// só marcam o id (tombstone), então os ids ficam estáveis até a próxima
+// compactação, que descarta os removidos e regrava o snapshot em segundo plano.
+// Várias sessões podem usar os mesmos arquivos: o log é o canal entre elas.
+typedef struct {
+    const char *arquivo;
+    const char *arquivo_log;
+    const char *arquivo_trava;
+    FILE *log;
+    int trava;                 // descritor do arquivo de trava (flock), -1 = fechado
+    int travas;                // travarLista aninhados
+    long lido;                 // fim da última entrada do log já aplicada
+    ino_t inode_log;           // muda quando uma compactação regrava o log
+    long seq;                  // última sequência usada no log
+    int entradas_log;          // entradas ainda não cobertas por um snapshot
+    unsigned char *removido;   // tombstones, por id
+    int capacidade;
+    int removidos;
+    // Compactação em andamento: a thread formata e grava 'copia' (registros
+    // ativos copiados no início) e só escreve em 'concluida'/'sucesso'
+    int (*formatar)(const void *lista, int total, TextoDinamico *saida);
+    size_t tamanho_registro;
+    pthread_t thread;
+    int compactando;
+    int concluida;
+    int sucesso;
+    long seq_snapshot;         // sequência coberta pelo snapshot sendo gravado
+    void *copia;
+    int total_copia;
+} Persistencia;
+
+// Contexto HTTP de longa duração, criado uma vez em main: os handles que o
+// usam compartilham conexões TLS abertas (keep-alive), DNS e sessões.
+typedef struct {
+    CURLSH *share;  // cache de DNS, sessões TLS e conexões
+    struct curl_slist *headers;
+    char *url;
+    char *url_stream;  // endpoint streamGenerateContent (SSE); NULL se indisponível
+} ClienteGemini;
+
+// Cache de respostas em disco: registros {hash, tamanho, texto} anexados ao
+// arquivo, com índice em memória (hash -> posição). O cabeçalho guarda o
+// hash do modelo de prompt compilado e a sequência do log de mentores; se
+// algum mudar, o cache é descartado. O arquivo é compartilhado entre
+// sessões: toda leitura ou escrita acontece com a trava, e a geração do
+// cabeçalho (nova a cada limpeza) diz se o índice em memória ainda vale.
+typedef struct {
+    uint64_t hash;   // 0 indica posição vazia
+    long offset;     // início do texto no arquivo
+    uint32_t tamanho;
+} EntradaCache;
+
+typedef struct {
+    FILE *arquivo;            // aberto para anexar: toda escrita vai para o fim
+    int trava;                // descritor do arquivo de trava (flock), -1 = fechado
+    EntradaCache *entradas;
+    int capacidade;
+    int total;
+    long fim;                 // fim do último registro indexado
+    uint64_t geracao;         // geração do arquivo que o índice descreve
+    uint64_t modelo;          // hash do modelo de prompt em uso (compilado uma vez)
+} CacheRespostas;
+
+// Histórico de resultados (ARQ_RESULTADOS): uma linha anexada por
+// recomendação, nunca reescrita. Em memória, o índice leva cada mentorado
+// (pelo nome) ao seu resultado mais recente, e cada resultado ao anterior.
+typedef struct {
+    long momento;            // segundos desde 1970
+    uint64_t entrada;        // hash das entradas (ver entradaDoMentorado)
+    char origem[16];         // estruturada, agrupada, texto, atribuicao ou local
+    char mentorado[100];
+    int total;               // mentores identificados (0 no texto livre)
+    char mentores[MAX_RECOMENDADOS][100];
+    double pontuacoes[MAX_RECOMENDADOS];  // nota do modelo (estruturada) ou pontuação local
+    int anterior;            // resultado anterior do mesmo mentorado (-1 = nenhum)
+} ResultadoMentoria;
+
+typedef struct {
+    uint64_t chave;  // hash do nome do mentorado; 0 indica posição vazia
+    int ultimo;
+} EntradaHistorico;
+
+typedef struct {
+    FILE *arquivo;           // aberto para anexar na primeira gravação
+    int trava;               // descritor do arquivo de trava (flock), -1 = fechado
+    ResultadoMentoria *itens;
+    int total;
+    int capacidade;
+    EntradaHistorico *indice;
+    int capacidade_indice;
+    int mentorados;
+} HistoricoResultados;
+
+// Tela do histórico: entradas atuais de cada mentorado, para marcar os
+// resultados desatualizados
+typedef struct {
+    const Mentorado *mentorados;
+    const uint64_t *entradas;
+} TelaHistorico;
+
+typedef struct {
+    int indice;         // posição do mentor na lista
+    double pontuacao;
+    char motivo[120];   // termos do objetivo encontrados na área
+} CandidatoMentor;
+
+// Rede de fluxo da atribuição global. Arestas em pares (a e a ^ 1 = reversa),
+// com a lista de cada nó encadeada por 'proxima'.
+typedef struct {
+    int *destino;
+    int *capacidade;   // residual
+    int *custo;
+    int *proxima;
+    int *primeira;     // por nó; -1 = sem arestas
+    int total_nos;
+    int total_arestas;
+} RedeFluxo;
+
+typedef struct {
+    long long distancia;
+    int no;
+} ItemHeap;
+
+// Resultado da atribuição global: um mentor por mentorado, respeitando as vagas
+typedef struct {
+    const Mentor *mentores;
+    const Mentorado *mentorados;
+    int *mentor;            // por mentorado; -1 = sem vaga entre os candidatos (ou removido)
+    double *pontuacao;      // compatibilidade local do par escolhido
+    int atribuidos;
+    int sem_vaga;
+    int mentores_usados;
+    double soma_pontuacao;
+    int maior_demanda;      // quantos mentorados teriam o mesmo 1º colocado sem o limite
+    int mais_procurado;     // esse mentor
+    double candidatos_ms;
+    double fluxo_ms;
+} AtribuicaoMentores;
+
+// Uma requisição em andamento na combinação em lote (curl_multi). No modo
+// agrupado ela leva vários mentorados em um só prompt.
+typedef struct {
+    CURL *curl;          // reaproveitado entre requisições
+    int total;           // mentorados nesta requisição; 0 indica slot livre
+    int mentorados[MAX_MENTORADOS_POR_REQUISICAO];
+    char *chaves[MAX_MENTORADOS_POR_REQUISICAO];  // chave do cache de cada um (no modo simples, o próprio prompt)
+    CandidatoMentor candidatos[MAX_MENTORADOS_POR_REQUISICAO][TOP_K_MENTORES];
+    int totalCandidatos[MAX_MENTORADOS_POR_REQUISICAO];
+    uint64_t entradas[MAX_MENTORADOS_POR_REQUISICAO];  // para o histórico de resultados
+    char *corpo;
+    RespostaGemini resposta;  // buffers reaproveitados entre requisições
+    double montagem_ms;  // prompts + corpo da requisição
+    int enviada;         // handle no curl_multi; 0 = aguardando o limitador ou nova tentativa
+    int tentativas;
+    long proxima_ms;     // não enviar antes deste instante
+} TransferenciaLote;
+
+// Um item da resposta agrupada, decodificado no próprio texto da resposta
+typedef struct {
+    int mentorado;              // posição no prompt, a partir de 1
+    int mentores[3];            // números da lista de mentores
+    int total_mentores;
+    const char *justificativa;  // NULL se ausente
+} ItemRespostaAgrupada;
+
+// Token bucket compartilhado por todas as requisições ao modelo. Um 429
+// pausa todas elas, não só a que o recebeu.
+typedef struct {
+    double taxa;          // fichas por ms (0 = sem limite)
+    double capacidade;
+    double fichas;
+    long ultimo_ms;
+    long pausado_ate_ms;
+} LimitadorTaxa;
+
+// Uma linha de metricas_gemini.log (tempos em ms, acumulados desde o início
+// da requisição, como o cURL os informa; tamanhos em bytes do corpo)
+typedef struct {
+    double dns;
+    double conexao;
+    double tls;
+    double primeiro_byte;
+    double total;
+    double enviados;
+    double recebidos;
+    double montagem;
+    double interpretacao;
+    long http_code;
+    int resultado;    // CURLcode
+} AmostraMetrica;
+
+// Resposta recebida em streaming (SSE): o texto é desenhado na caixa à medida
+// que os eventos chegam, sem esperar o fim da resposta
+typedef struct {
+    CURL *curl;
+    int modo;                      // 0 = indefinido, 1 = eventos SSE, 2 = corpo comum (erro)
+    TextoDinamico pendente;  // bytes sem fim de linha ainda (ou corpo inteiro no modo 2)
+    TextoDinamico texto;     // texto completo recebido até agora
+    double tempo_interpretacao_ms; // gasto interpretando os eventos (sem o desenho)
+    int desenhar;                  // 0 = só acumula (ninguém acompanhando a consulta)
+    int progresso_na_tela;         // linha de progresso aberta antes da caixa
+    int caixa_aberta;
+    int linha_aberta;
+    int coluna;                    // caracteres já impressos na linha atual
+} RespostaStream;
+
+// Candidatos de uma consulta, copiados na montagem do prompt: a resposta é
+// validada contra eles mesmo que a lista de mentores mude depois. 'local' é
+// o que vai para o histórico se o modelo não responder.
+typedef struct {
+    int total;
+    int ids[TOP_K_MENTORES];
+    char nomes[TOP_K_MENTORES][100];
+    ResultadoMentoria local;
+} CandidatosConsulta;
+
+typedef enum { CONSULTA_EM_ANDAMENTO, CONSULTA_CONCLUIDA, CONSULTA_LOCAL, CONSULTA_CANCELADA } EstadoConsulta;
+
+// Consulta ao modelo em segundo plano: a transferência avança enquanto o
+// programa espera teclas, então o menu continua utilizável
+typedef struct {
+    EstadoConsulta estado;
+    char mentorado[100];
+    int mentorado_id;      // posição no momento do pedido (o nome confirma o dono)
+    char *prompt;
+    char *corpo;
+    char *alternativa;     // recomendação local, usada se a consulta falhar ou for cancelada
+    char *texto;           // resultado final
+    CURL *curl;
+    RespostaStream fluxo;  // texto parcial disponível durante a consulta
+    long inicio_ms;
+    double montagem_ms;
+    int vista;
+    int enviada;           // 0 = aguardando o limitador ou nova tentativa
+    int tentativas;
+    long proxima_ms;
+    long ultimo_erro;      // código HTTP da última falha (0 = erro de rede)
+    int estruturada;                       // resposta no formato de ESQUEMA_RECOMENDACAO
+    CandidatosConsulta *candidatos;
+    RecomendacaoEstruturada *recomendacao; // resultado validado, até ser guardado no mentorado
+} Consulta;
+
+typedef struct {
+    CURLM *multi;
+    ClienteGemini *cliente;
+    CacheRespostas *cache;
+    Consulta **itens;      // ponteiros: o callback do cURL guarda o endereço da consulta
+    int total;
+    int capacidade;
+    int em_andamento;
+    CURL *livres[CONCORRENCIA_PADRAO];  // handles reaproveitados entre consultas
+    int total_livres;
+} FilaConsultas;
 
 // FUNÇÕES DE INTERFACE
 
@@ -112,309 +547,4238 @@ void limparBufferEntrada() {
     while ((c = getchar()) != '\n' && c != EOF);
 }
 
-int capturaTecla() {
-    struct termios oldt, newt;
-    int ch;
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    ch = getchar();
-    if (ch == 27) {
-        int next1 = getchar();
-        (void)next1;
-        int next2 = getchar();
-        if (next2 == 'A') ch = 'w';
-        else if (next2 == 'B') ch = 's';
-        else if (next2 == 'C') ch = 'd';
-        else if (next2 == 'D') ch = 'a';
+// CONSTRUÇÃO DE TEXTO E JSON
+
+int reservarTexto(TextoDinamico *t, size_t extra) {
+    if (t->tamanho + extra + 1 <= t->capacidade) return 1;
+    size_t nova = t->capacidade ? t->capacidade : 256;
+    while (nova < t->tamanho + extra + 1) nova *= 2;
+    char *ptr = realloc(t->dados, nova);
+    if (!ptr) return 0;
+    t->dados = ptr;
+    t->capacidade = nova;
+    return 1;
+}
+
+int anexarTexto(TextoDinamico *t, const char *dados, size_t tamanho) {
+    if (!reservarTexto(t, tamanho)) return 0;
+    memcpy(t->dados + t->tamanho, dados, tamanho);
+    t->tamanho += tamanho;
+    t->dados[t->tamanho] = '\0';
+    return 1;
+}
+
+int anexarString(TextoDinamico *t, const char *texto) {
+    return anexarTexto(t, texto, strlen(texto));
+}
+
+int anexarFormatado(TextoDinamico *t, const char *formato, ...) {
+    va_list args;
+    va_start(args, formato);
+    int n = vsnprintf(NULL, 0, formato, args);
+    va_end(args);
+    if (n < 0 || !reservarTexto(t, (size_t)n)) return 0;
+    va_start(args, formato);
+    vsnprintf(t->dados + t->tamanho, (size_t)n + 1, formato, args);
+    va_end(args);
+    t->tamanho += (size_t)n;
+    return 1;
+}
+
+// Escreve 'texto' como string JSON (com aspas), escapando aspas, barras e
+// caracteres de controle. Bytes UTF-8 são copiados sem alteração.
+int anexarStringJson(TextoDinamico *t, const char *texto) {
+    static const char hex[] = "0123456789abcdef";
+    size_t tamanho = strlen(texto);
+    if (!reservarTexto(t, tamanho + 2)) return 0;
+    t->dados[t->tamanho++] = '"';
+    const char *inicio = texto;  // trecho ainda sem escapes pendente de cópia
+    for (const char *p = texto; ; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c != '\0' && c != '"' && c != '\\' && c >= 0x20) continue;
+        if (p > inicio && !anexarTexto(t, inicio, (size_t)(p - inicio))) return 0;
+        if (c == '\0') break;
+        char escape[7] = {'\\', 0, 0, 0, 0, 0, 0};
+        size_t n = 2;
+        switch (c) {
+            case '"':  escape[1] = '"'; break;
+            case '\\': escape[1] = '\\'; break;
+            case '\n': escape[1] = 'n'; break;
+            case '\r': escape[1] = 'r'; break;
+            case '\t': escape[1] = 't'; break;
+            case '\b': escape[1] = 'b'; break;
+            case '\f': escape[1] = 'f'; break;
+            default:
+                memcpy(escape + 1, "u00", 3);
+                escape[4] = hex[c >> 4];
+                escape[5] = hex[c & 0xF];
+                n = 6;
+        }
+        if (!anexarTexto(t, escape, n)) return 0;
+        inicio = p + 1;
     }
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    return ch;
+    return anexarTexto(t, "\"", 1);
 }
 
-void esperarPressionarQ() {
-    char input[10];
-    print_border_top();
-    print_line("Pressione 'q' para voltar ao menu...");
-    print_border_bottom();
-    do {
-        printf("> ");
-        if (fgets(input, sizeof(input), stdin)) {
-            if (input[0] == 'q' || input[0] == 'Q') break;
+// Entrega o buffer ao chamador (que deve liberá-lo com free)
+char* extrairTexto(TextoDinamico *t) {
+    char *dados = t->dados;
+    if (!dados) dados = strdup("");
+    memset(t, 0, sizeof(*t));
+    return dados;
+}
+
+void liberarTexto(TextoDinamico *t) {
+    free(t->dados);
+    memset(t, 0, sizeof(*t));
+}
+
+// PERSISTÊNCIA INCREMENTAL
+
+// Linhas do snapshot, no mesmo formato lido por carregarMentores/carregarMentorados.
+// Retorna 0 se faltou memória: um snapshot incompleto não pode ser instalado.
+int formatarMentores(const void *lista, int total, TextoDinamico *saida) {
+    const Mentor *mentores = (const Mentor *)lista;
+    int ok = 1;
+    for (int i = 0; i < total && ok; i++) {
+        ok = mentores[i].vagas > 0
+            ? anexarFormatado(saida, "%s;%s;%d;%d\n", mentores[i].nome, mentores[i].area, mentores[i].experiencia, mentores[i].vagas)
+            : anexarFormatado(saida, "%s;%s;%d\n", mentores[i].nome, mentores[i].area, mentores[i].experiencia);
+    }
+    return ok;
+}
+
+int formatarMentorados(const void *lista, int total, TextoDinamico *saida) {
+    const Mentorado *mentorados = (const Mentorado *)lista;
+    int ok = 1;
+    for (int i = 0; i < total && ok; i++) ok = anexarFormatado(saida, "%s;%s\n", mentorados[i].nome, mentorados[i].objetivo);
+    return ok;
+}
+
+Persistencia persistencia_mentores = {.arquivo = ARQ_MENTORES, .arquivo_log = ARQ_LOG_MENTORES,
+                                      .arquivo_trava = ARQ_TRAVA_MENTORES, .trava = -1,
+                                      .formatar = formatarMentores, .tamanho_registro = sizeof(Mentor)};
+Persistencia persistencia_mentorados = {.arquivo = ARQ_MENTORADOS, .arquivo_log = ARQ_LOG_MENTORADOS,
+                                        .arquivo_trava = ARQ_TRAVA_MENTORADOS, .trava = -1,
+                                        .formatar = formatarMentorados, .tamanho_registro = sizeof(Mentorado)};
+
+int registroAtivo(const Persistencia *p, int id) {
+    return id >= p->capacidade || !p->removido[id];
+}
+
+int totalAtivos(const Persistencia *p, int total) {
+    return total - p->removidos;
+}
+
+void marcarRemovido(Persistencia *p, int id) {
+    if (id >= p->capacidade) {
+        int nova = p->capacidade ? p->capacidade : 64;
+        while (nova <= id) nova *= 2;
+        unsigned char *res = realloc(p->removido, nova);
+        if (!res) return;
+        memset(res + p->capacidade, 0, nova - p->capacidade);
+        p->removido = res;
+        p->capacidade = nova;
+    }
+    if (!p->removido[id]) {
+        p->removido[id] = 1;
+        p->removidos++;
+    }
+}
+
+void limparRemovidos(Persistencia *p) {
+    if (p->removido) memset(p->removido, 0, p->capacidade);
+    p->removidos = 0;
+}
+
+// Trava exclusiva entre sessões: flock no arquivo de trava, aberto na
+// primeira vez. Sem ele, a sessão segue sem trava.
+void travarArquivo(int *trava, const char *arquivo_trava) {
+    if (*trava < 0) *trava = open(arquivo_trava, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (*trava < 0) {
+        printf("Erro ao abrir %s; alterações de outras sessões podem ser perdidas.\n", arquivo_trava);
+        return;
+    }
+    while (flock(*trava, LOCK_EX) != 0 && errno == EINTR);
+}
+
+void destravarArquivo(int trava) {
+    if (trava >= 0) flock(trava, LOCK_UN);
+}
+
+// Trava da lista. Quem grava no log ou troca o snapshot a segura, depois de
+// aplicar o que as outras sessões gravaram. Chamadas aninhadas só contam.
+void travarLista(Persistencia *p) {
+    if (p->travas++ > 0) return;
+    travarArquivo(&p->trava, p->arquivo_trava);
+}
+
+void destravarLista(Persistencia *p) {
+    if (--p->travas > 0) return;
+    destravarArquivo(p->trava);
+}
+
+// Anexa "seq;<entrada>" ao log. Cada alteração custa uma escrita curta,
+// independentemente do tamanho da lista. Chamada com a lista travada e já
+// em dia com o log, então a entrada desta sessão não é relida.
+void registrarNoLog(Persistencia *p, const char *formato, ...) {
+    if (!p->log) p->log = fopen(p->arquivo_log, "a");
+    if (!p->log) {
+        printf("Erro ao abrir %s para escrita.\n", p->arquivo_log);
+        return;
+    }
+    va_list args;
+    va_start(args, formato);
+    fprintf(p->log, "%ld;", ++p->seq);
+    vfprintf(p->log, formato, args);
+    fputc('\n', p->log);
+    va_end(args);
+    fflush(p->log);
+    struct stat st;
+    if (fstat(fileno(p->log), &st) == 0) p->lido = st.st_size;
+    p->entradas_log++;
+}
+
+// Lê a linha "#seq N" do início do snapshot (arquivos antigos não têm: N = 0)
+long lerCabecalhoSnapshot(FILE *f) {
+    long seq = 0;
+    int c = fgetc(f);
+    if (c == '#') {
+        if (fscanf(f, "seq %ld", &seq) != 1) seq = 0;
+        while ((c = fgetc(f)) != '\n' && c != EOF);
+    } else if (c != EOF) {
+        ungetc(c, f);
+    }
+    return seq;
+}
+
+// Sequência coberta pelo snapshot em disco (0 se ele não existe)
+long seqDoSnapshot(const char *arquivo) {
+    FILE *f = fopen(arquivo, "r");
+    if (!f) return 0;
+    long seq = lerCabecalhoSnapshot(f);
+    fclose(f);
+    return seq;
+}
+
+// Aplica à lista uma entrada do log ('+', '-' ou '#'), ou uma linha do
+// snapshot como '+'. 'campos' vem sem o ';' inicial. Retorna o novo total.
+typedef int (*AplicarEntrada)(void **lista, int total, char op, const char *campos);
+
+// Aplica as entradas do log ainda não lidas por esta sessão: na carga, as
+// posteriores ao snapshot; depois, as que outras sessões gravaram. A leitura
+// começa onde a anterior parou. Se faltam entradas que uma compactação de
+// outra sessão já tirou do log, para e marca 'desatualizada'.
+int lerLog(Persistencia *p, void **lista, int total, AplicarEntrada aplicar, int *desatualizada) {
+    struct stat st;
+    if (stat(p->arquivo_log, &st) != 0) return total;
+    if (st.st_ino != p->inode_log || st.st_size < p->lido) {
+        // Log regravado por uma compactação: o arquivo novo é lido do início
+        if (p->log) fclose(p->log);
+        p->log = NULL;
+        p->inode_log = st.st_ino;
+        p->lido = 0;
+        if (desatualizada && seqDoSnapshot(p->arquivo) > p->seq) {
+            *desatualizada = 1;
+            return total;
         }
-    } while (1);
+    }
+    if (st.st_size == p->lido) return total;
+    FILE *f = fopen(p->arquivo_log, "r");
+    if (!f) return total;
+    fseek(f, p->lido, SEEK_SET);
+    char linha[512];
+    long seq;
+    char op;
+    int n;
+    int parcial = 0;
+    while (fgets(linha, sizeof(linha), f)) {
+        if (!strchr(linha, '\n') || sscanf(linha, "%ld;%c%n", &seq, &op, &n) != 2) {
+            parcial = 1;
+            break;
+        }
+        if (desatualizada && seq > p->seq + 1) {
+            *desatualizada = 1;
+            break;
+        }
+        p->lido = ftell(f);
+        if (seq <= p->seq) continue;
+        p->seq = seq;
+        p->entradas_log++;
+        total = aplicar(lista, total, op, linha + n + (linha[n] == ';'));
+        if (op == '#') p->entradas_log = 0;
+    }
+    fclose(f);
+    // Uma escrita interrompida deixa a última linha pela metade: ela é
+    // descartada (com a trava, nenhuma outra sessão está no meio de uma escrita)
+    if (parcial && truncate(p->arquivo_log, p->lido) != 0) printf("Erro ao reparar %s.\n", p->arquivo_log);
+    return total;
 }
 
-int confirmarRemocao(const char *mensagem) {
-    char input[10];
-    print_border_top();
-    print_line(mensagem);
-    print_line("Pressione 'y' para sim ou 'n' para não.");
-    print_border_bottom();
-    do {
-        printf("> ");
-        if (fgets(input, sizeof(input), stdin)) {
-            if (input[0] == 'y' || input[0] == 'Y') return 1;
-            if (input[0] == 'n' || input[0] == 'N') return 0;
+// Descarta a lista em memória, lê o snapshot e aplica o log posterior a ele
+int recarregarLista(Persistencia *p, void **lista, int total, AplicarEntrada aplicar) {
+    if (total > 0) {
+        for (int id = 0; id < total; id++) marcarRemovido(p, id);
+        total = aplicar(lista, total, '#', "");
+    }
+    if (p->log) fclose(p->log);
+    p->log = NULL;
+    p->inode_log = 0;
+    p->lido = 0;
+    p->seq = 0;
+    p->entradas_log = 0;
+    FILE *f = fopen(p->arquivo, "r");
+    if (f) {
+        p->seq = lerCabecalhoSnapshot(f);
+        char linha[512];
+        while (fgets(linha, sizeof(linha), f)) total = aplicar(lista, total, '+', linha);
+        fclose(f);
+    }
+    return lerLog(p, lista, total, aplicar, NULL);
+}
+
+// Traz a lista em memória ao estado do log. Sem entradas novas, custa um
+// stat e nenhuma leitura. Retorna o novo total.
+int sincronizarLista(Persistencia *p, void **lista, int total, AplicarEntrada aplicar) {
+    struct stat st;
+    if (stat(p->arquivo_log, &st) == 0 && st.st_ino == p->inode_log && st.st_size == p->lido) return total;
+    travarLista(p);
+    int desatualizada = 0;
+    total = lerLog(p, lista, total, aplicar, &desatualizada);
+    if (desatualizada) total = recarregarLista(p, lista, total, aplicar);
+    destravarLista(p);
+    return total;
+}
+
+// Nome do snapshot em gravação: um por processo, já que várias sessões
+// podem compactar ao mesmo tempo
+void nomeSnapshotTemporario(const Persistencia *p, char *saida, size_t tamanho) {
+    snprintf(saida, tamanho, "%s.%ld.tmp", p->arquivo, (long)getpid());
+}
+
+void* gravarSnapshot(void *arg) {
+    Persistencia *p = (Persistencia *)arg;
+    TextoDinamico conteudo = {0};
+    int ok = anexarFormatado(&conteudo, "#seq %ld\n", p->seq_snapshot);
+    ok = ok && p->formatar(p->copia, p->total_copia, &conteudo);
+
+    // Sem o conteúdo completo nada é gravado: o log continua valendo
+    char temporario[256];
+    nomeSnapshotTemporario(p, temporario, sizeof(temporario));
+    FILE *f = ok ? fopen(temporario, "w") : NULL;
+    if (!f) ok = 0;
+    if (f) {
+        ok = fwrite(conteudo.dados, 1, conteudo.tamanho, f) == conteudo.tamanho;
+        ok = (fflush(f) == 0) && ok;
+        ok = (fsync(fileno(f)) == 0) && ok;
+        ok = (fclose(f) == 0) && ok;
+        if (!ok) remove(temporario);
+    }
+    liberarTexto(&conteudo);
+    p->sucesso = ok;
+    __atomic_store_n(&p->concluida, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Depois que o snapshot novo está no lugar, as entradas do log que ele
+// cobre são descartadas (o log é regravado só com as posteriores, inclusive
+// as de outras sessões)
+void truncarLog(Persistencia *p) {
+    char temporario[256];
+    snprintf(temporario, sizeof(temporario), "%s.tmp", p->arquivo_log);
+    if (p->log) fclose(p->log);
+    p->log = NULL;
+    FILE *antigo = fopen(p->arquivo_log, "r");
+    FILE *novo = fopen(temporario, "w");
+    if (!antigo || !novo) {
+        if (antigo) fclose(antigo);
+        if (novo) fclose(novo);
+        remove(temporario);
+        return;
+    }
+    char linha[512];
+    long lido = 0;
+    while (fgets(linha, sizeof(linha), antigo)) {
+        long seq = atol(linha);
+        if (seq <= p->seq_snapshot) continue;
+        fputs(linha, novo);
+        if (seq <= p->seq) lido = ftell(novo);
+    }
+    fclose(antigo);
+    struct stat st;
+    if (fclose(novo) == 0 && rename(temporario, p->arquivo_log) == 0 && stat(p->arquivo_log, &st) == 0) {
+        p->inode_log = st.st_ino;
+        p->lido = lido;
+    } else {
+        remove(temporario);
+    }
+}
+
+// Põe o snapshot gravado no lugar e enxuga o log. Se outra sessão já
+// instalou um snapshot mais recente, o desta é descartado.
+int instalarSnapshot(Persistencia *p) {
+    char temporario[256];
+    nomeSnapshotTemporario(p, temporario, sizeof(temporario));
+    travarLista(p);
+    int ok = 1;
+    // rename é atômico: quem abrir o arquivo vê o snapshot antigo ou o novo
+    if (seqDoSnapshot(p->arquivo) < p->seq_snapshot) ok = rename(temporario, p->arquivo) == 0;
+    else remove(temporario);
+    if (ok) truncarLog(p);
+    else remove(temporario);
+    destravarLista(p);
+    return ok;
+}
+
+// Recolhe uma compactação terminada; 'esperar' bloqueia até ela acabar
+void finalizarCompactacao(Persistencia *p, int esperar) {
+    if (!p->compactando) return;
+    if (!esperar && !__atomic_load_n(&p->concluida, __ATOMIC_ACQUIRE)) return;
+    if (p->thread) pthread_join(p->thread, NULL);
+    p->thread = 0;
+    if (!p->sucesso || !instalarSnapshot(p)) printf("Erro ao gravar %s; o log de alterações foi mantido.\n", p->arquivo);
+    free(p->copia);
+    p->copia = NULL;
+    p->compactando = 0;
+}
+
+// Inicia a gravação do snapshot da lista (já compactada) em uma thread.
+// A marca '#' no log registra o ponto em que os ids foram renumerados.
+void iniciarCompactacao(Persistencia *p, const void *lista, int total) {
+    p->copia = malloc(p->tamanho_registro * (total ? total : 1));
+    if (!p->copia) return;  // tenta de novo na próxima alteração
+    memcpy(p->copia, lista, p->tamanho_registro * total);
+    p->total_copia = total;
+    registrarNoLog(p, "#");
+    p->seq_snapshot = p->seq;
+    p->entradas_log = 0;
+    p->concluida = 0;
+    p->compactando = 1;
+    if (pthread_create(&p->thread, NULL, gravarSnapshot, p) != 0) {
+        p->thread = 0;
+        gravarSnapshot(p);
+        finalizarCompactacao(p, 1);
+    }
+}
+
+// Vale a pena compactar quando o log passa do limite e de 1/4 dos registros ativos
+int precisaCompactar(const Persistencia *p, int total) {
+    return !p->compactando && p->entradas_log >= LIMITE_LOG_COMPACTACAO && p->entradas_log * 4 >= totalAtivos(p, total);
+}
+
+void encerrarPersistencia(Persistencia *p) {
+    finalizarCompactacao(p, 1);
+    if (p->log) fclose(p->log);
+    p->log = NULL;
+    if (p->trava >= 0) close(p->trava);
+    p->trava = -1;
+    free(p->removido);
+    p->removido = NULL;
+    p->capacidade = p->removidos = 0;
+}
+
+// ÍNDICE DE ÁREAS
+
+IndiceAreas indice_areas = {NULL, 0, 0, 0};
+MatrizVetores vetores_areas = {NULL, 0, 0};
+int capacidade_mentores = 0;
+int capacidade_mentorados = 0;
+
+// Minúsculas sem acentos (UTF-8 -> ASCII); independe do locale
+void normalizarTexto(const char *entrada, char *saida, size_t tamanho) {
+    size_t n = 0;
+    const unsigned char *p = (const unsigned char *)entrada;
+    while (*p && n + 1 < tamanho) {
+        unsigned int c = *p++;
+        if (c >= 0xC0 && c < 0xE0 && (*p & 0xC0) == 0x80) {
+            c = ((c & 0x1F) << 6) | (*p++ & 0x3F);
+        } else if (c >= 0x80) {
+            // Outros caracteres multibyte são tratados como separadores
+            while ((*p & 0xC0) == 0x80) p++;
+            c = ' ';
         }
-    } while (1);
+        if (c >= 0xC0 && c <= 0xFF) {
+            static const char latin1[] = "aaaaaaaceeeeiiiidnooooo ouuuuyts" "aaaaaaaceeeeiiiidnooooo ouuuuyty";
+            c = (unsigned char)latin1[c - 0xC0];
+        }
+        saida[n++] = (char)tolower((int)c);
+    }
+    saida[n] = '\0';
+}
+
+uint64_t hashTexto(const char *texto) {
+    uint64_t h = 1469598103934665603ULL; // FNV-1a 64 bits
+    for (const unsigned char *p = (const unsigned char *)texto; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    return h ? h : 1;
+}
+
+// Chave do índice: área normalizada, com espaços repetidos e das pontas removidos
+void chaveArea(const char *area, char *saida, size_t tamanho) {
+    char normalizada[256];
+    normalizarTexto(area, normalizada, sizeof(normalizada));
+    size_t n = 0;
+    for (const char *p = normalizada; *p && n + 1 < tamanho; p++) {
+        if (isspace((unsigned char)*p) && (n == 0 || saida[n - 1] == ' ')) continue;
+        saida[n++] = isspace((unsigned char)*p) ? ' ' : *p;
+    }
+    if (n > 0 && saida[n - 1] == ' ') n--;
+    saida[n] = '\0';
+}
+
+// Posição da chave na tabela (ocupada com a chave ou a livre onde ela entraria)
+int posicaoGrupoArea(const IndiceAreas *indice, const char *chave) {
+    int mascara = indice->capacidade - 1;
+    int pos = (int)(hashTexto(chave) & (uint64_t)mascara);
+    while (indice->grupos[pos].chave && strcmp(indice->grupos[pos].chave, chave) != 0) {
+        pos = (pos + 1) & mascara;
+    }
+    return pos;
+}
+
+int expandirIndiceAreas(IndiceAreas *indice) {
+    int nova = indice->capacidade ? indice->capacidade * 2 : 64;
+    GrupoArea *grupos = calloc(nova, sizeof(GrupoArea));
+    if (!grupos) return 0;
+    IndiceAreas novo = {grupos, nova, indice->usados, indice->total_ids};
+    for (int i = 0; i < indice->capacidade; i++) {
+        if (indice->grupos[i].chave) novo.grupos[posicaoGrupoArea(&novo, indice->grupos[i].chave)] = indice->grupos[i];
+    }
+    free(indice->grupos);
+    *indice = novo;
+    return 1;
+}
+
+// Grupo da área (NULL se nenhum mentor tem essa área)
+GrupoArea* grupoDaArea(const char *area) {
+    if (indice_areas.capacidade == 0) return NULL;
+    char chave[256];
+    chaveArea(area, chave, sizeof(chave));
+    GrupoArea *grupo = &indice_areas.grupos[posicaoGrupoArea(&indice_areas, chave)];
+    return grupo->chave ? grupo : NULL;
+}
+
+void indexarMentorArea(const Mentor *mentor, int id) {
+    if ((indice_areas.usados + 1) * 4 > indice_areas.capacidade * 3 && !expandirIndiceAreas(&indice_areas)) return;
+    char chave[256];
+    chaveArea(mentor->area, chave, sizeof(chave));
+    GrupoArea *grupo = &indice_areas.grupos[posicaoGrupoArea(&indice_areas, chave)];
+    if (!grupo->chave) {
+        grupo->chave = strdup(chave);
+        if (!grupo->chave) return;
+        grupo->linha = -1;  // vetorizada na próxima busca por similaridade
+        indice_areas.usados++;
+    }
+    if (grupo->total == grupo->capacidade) {
+        int nova = grupo->capacidade ? grupo->capacidade * 2 : 4;
+        int *ids = realloc(grupo->ids, nova * sizeof(int));
+        if (!ids) return;
+        grupo->ids = ids;
+        grupo->capacidade = nova;
+    }
+    grupo->ids[grupo->total++] = id;
+    grupo->ativos++;
+    indice_areas.total_ids++;
+}
+
+// O id continua na lista do grupo (tombstone) até a próxima reconstrução
+void desindexarMentorArea(const Mentor *mentor) {
+    GrupoArea *grupo = grupoDaArea(mentor->area);
+    if (grupo && grupo->ativos > 0) grupo->ativos--;
+}
+
+// Aplica a renumeração de uma compactação (novo_id[id] = -1 para removidos)
+// sem recalcular as chaves
+void renumerarIndiceAreas(const int *novo_id, int total) {
+    for (int g = 0; g < indice_areas.capacidade; g++) {
+        GrupoArea *grupo = &indice_areas.grupos[g];
+        int n = 0;
+        for (int i = 0; i < grupo->total; i++) {
+            if (novo_id[grupo->ids[i]] >= 0) grupo->ids[n++] = novo_id[grupo->ids[i]];
+        }
+        grupo->total = grupo->ativos = n;
+    }
+    indice_areas.total_ids = total;
+}
+
+void liberarIndiceAreas() {
+    for (int g = 0; g < indice_areas.capacidade; g++) {
+        free(indice_areas.grupos[g].chave);
+        free(indice_areas.grupos[g].ids);
+    }
+    free(indice_areas.grupos);
+    memset(&indice_areas, 0, sizeof(indice_areas));
+    free(vetores_areas.dados);
+    memset(&vetores_areas, 0, sizeof(vetores_areas));
+}
+
+void reconstruirIndiceAreas(const Mentor *mentores, int total) {
+    liberarIndiceAreas();
+    for (int i = 0; i < total; i++) {
+        indexarMentorArea(&mentores[i], i);
+        if (!registroAtivo(&persistencia_mentores, i)) desindexarMentorArea(&mentores[i]);
+    }
+}
+
+// Garante espaço para mais um item, dobrando a capacidade quando necessário
+int reservarLista(void **lista, int total, int *capacidade, size_t tamanho_item) {
+    if (total < *capacidade) return 1;
+    int nova = *capacidade ? *capacidade * 2 : 16;
+    void *res = realloc(*lista, tamanho_item * nova);
+    if (!res) return 0;
+    *lista = res;
+    *capacidade = nova;
+    return 1;
 }
 
 // FUNÇÕES DE DADOS
 
-int carregarMentores(Mentor **lista) {
-    FILE *f = fopen(ARQ_MENTORES, "r");
-    if (!f) return 0;
-    int count = 0;
+// Descarta os removidos e renumera os ids (só em compactações)
+int compactarMentores(Mentor *lista, int total) {
+    int *novo_id = malloc(sizeof(int) * (total ? total : 1));
+    int n = 0;
+    for (int i = 0; i < total; i++) {
+        int ativo = registroAtivo(&persistencia_mentores, i);
+        if (novo_id) novo_id[i] = ativo ? n : -1;
+        if (ativo) lista[n++] = lista[i];
+    }
+    limparRemovidos(&persistencia_mentores);
+    if (novo_id) renumerarIndiceAreas(novo_id, n);
+    else reconstruirIndiceAreas(lista, n);
+    free(novo_id);
+    return n;
+}
+
+int compactarMentorados(Mentorado *lista, int total) {
+    int n = 0;
+    for (int i = 0; i < total; i++) {
+        if (registroAtivo(&persistencia_mentorados, i)) lista[n++] = lista[i];
+        else free(lista[i].recomendacao);
+    }
+    limparRemovidos(&persistencia_mentorados);
+    return n;
+}
+
+// Compacta em memória e grava o snapshot em segundo plano, se necessário
+int verificarCompactacaoMentores(Mentor *lista, int total) {
+    Persistencia *p = &persistencia_mentores;
+    finalizarCompactacao(p, 0);
+    if (!precisaCompactar(p, total)) return total;
+    total = compactarMentores(lista, total);
+    iniciarCompactacao(p, lista, total);
+    return total;
+}
+
+int verificarCompactacaoMentorados(Mentorado *lista, int total) {
+    Persistencia *p = &persistencia_mentorados;
+    finalizarCompactacao(p, 0);
+    if (!precisaCompactar(p, total)) return total;
+    total = compactarMentorados(lista, total);
+    iniciarCompactacao(p, lista, total);
+    return total;
+}
+
+int aplicarEntradaMentores(void **lista, int total, char op, const char *campos) {
+    Mentor **mentores = (Mentor **)lista;
     Mentor temp;
-    while (fscanf(f, "%99[^;];%99[^;];%d\n", temp.nome, temp.area, &temp.experiencia) == 3) {
-        Mentor *res = realloc(*lista, sizeof(Mentor) * (count + 1));
-        if (!res) { fclose(f); return count; }
-        *lista = res;
-        (*lista)[count++] = temp;
+    int id;
+    temp.vagas = 0;
+    // Último campo opcional: vagas
+    if (op == '+' && sscanf(campos, "%99[^;];%99[^;];%d;%d", temp.nome, temp.area, &temp.experiencia, &temp.vagas) >= 3) {
+        if (!reservarLista(lista, total, &capacidade_mentores, sizeof(Mentor))) return total;
+        (*mentores)[total] = temp;
+        indexarMentorArea(&temp, total);
+        return total + 1;
+    }
+    if (op == '-' && sscanf(campos, "%d", &id) == 1 && id >= 0 && id < total && registroAtivo(&persistencia_mentores, id)) {
+        marcarRemovido(&persistencia_mentores, id);
+        desindexarMentorArea(&(*mentores)[id]);
+    } else if (op == '#') {
+        total = compactarMentores(*mentores, total);
+    }
+    return total;
+}
+
+int aplicarEntradaMentorados(void **lista, int total, char op, const char *campos) {
+    Mentorado **mentorados = (Mentorado **)lista;
+    Mentorado temp = {0};
+    int id;
+    if (op == '+' && sscanf(campos, "%99[^;];%199[^\n]", temp.nome, temp.objetivo) == 2) {
+        if (!reservarLista(lista, total, &capacidade_mentorados, sizeof(Mentorado))) return total;
+        (*mentorados)[total] = temp;
+        return total + 1;
+    }
+    if (op == '-' && sscanf(campos, "%d", &id) == 1 && id >= 0 && id < total) {
+        marcarRemovido(&persistencia_mentorados, id);
+    } else if (op == '#') {
+        total = compactarMentorados(*mentorados, total);
+    }
+    return total;
+}
+
+// Carrega o snapshot e reaplica as entradas do log posteriores a ele
+int carregarMentores(Mentor **lista) {
+    travarLista(&persistencia_mentores);
+    int total = recarregarLista(&persistencia_mentores, (void **)lista, 0, aplicarEntradaMentores);
+    total = verificarCompactacaoMentores(*lista, total);
+    destravarLista(&persistencia_mentores);
+    return total;
+}
+
+int carregarMentorados(Mentorado **lista) {
+    travarLista(&persistencia_mentorados);
+    int total = recarregarLista(&persistencia_mentorados, (void **)lista, 0, aplicarEntradaMentorados);
+    total = verificarCompactacaoMentorados(*lista, total);
+    destravarLista(&persistencia_mentorados);
+    return total;
+}
+
+// Aplica o que outras sessões gravaram desde a última leitura. Chamadas a
+// cada volta do menu; sem novidades, não leem nada.
+int sincronizarMentores(Mentor **lista, int total) {
+    return sincronizarLista(&persistencia_mentores, (void **)lista, total, aplicarEntradaMentores);
+}
+
+int sincronizarMentorados(Mentorado **lista, int total) {
+    return sincronizarLista(&persistencia_mentorados, (void **)lista, total, aplicarEntradaMentorados);
+}
+
+// As alterações travam a lista e a põem em dia com o log antes de gravar,
+// então as entradas de todas as sessões formam uma única sequência e os
+// ids coincidem entre elas
+int adicionarMentor(Mentor **lista, int total, Mentor novo) {
+    Persistencia *p = &persistencia_mentores;
+    travarLista(p);
+    total = sincronizarMentores(lista, total);
+    if (reservarLista((void **)lista, total, &capacidade_mentores, sizeof(Mentor))) {
+        (*lista)[total] = novo;
+        indexarMentorArea(&novo, total);
+        registrarNoLog(p, "+;%s;%s;%d;%d", novo.nome, novo.area, novo.experiencia, novo.vagas);
+        total = verificarCompactacaoMentores(*lista, total + 1);
+    }
+    destravarLista(p);
+    return total;
+}
+
+int adicionarMentorado(Mentorado **lista, int total, Mentorado novo) {
+    Persistencia *p = &persistencia_mentorados;
+    travarLista(p);
+    total = sincronizarMentorados(lista, total);
+    if (reservarLista((void **)lista, total, &capacidade_mentorados, sizeof(Mentorado))) {
+        (*lista)[total] = novo;
+        registrarNoLog(p, "+;%s;%s", novo.nome, novo.objetivo);
+        total = verificarCompactacaoMentorados(*lista, total + 1);
+    }
+    destravarLista(p);
+    return total;
+}
+
+// Remoção O(1): marca o id e anexa uma linha ao log. Retorna o novo total,
+// que só diminui quando a remoção (ou a sincronização) compacta a lista.
+// Se outra sessão compactou depois da seleção, o nome confirma o registro;
+// se ela já o removeu, não há o que fazer.
+int removerMentor(Mentor **lista, int total, int indice) {
+    Persistencia *p = &persistencia_mentores;
+    if (indice < 0 || indice >= total) return total;
+    char nome[sizeof((*lista)->nome)];
+    memcpy(nome, (*lista)[indice].nome, sizeof(nome));
+    travarLista(p);
+    total = sincronizarMentores(lista, total);
+    if (indice >= total || strcmp((*lista)[indice].nome, nome) != 0) {
+        for (indice = 0; indice < total; indice++) {
+            if (registroAtivo(p, indice) && strcmp((*lista)[indice].nome, nome) == 0) break;
+        }
+    }
+    if (indice < total && registroAtivo(p, indice)) {
+        marcarRemovido(p, indice);
+        desindexarMentorArea(&(*lista)[indice]);
+        registrarNoLog(p, "-;%d", indice);
+        total = verificarCompactacaoMentores(*lista, total);
+    }
+    destravarLista(p);
+    return total;
+}
+
+int removerMentorado(Mentorado **lista, int total, int indice) {
+    Persistencia *p = &persistencia_mentorados;
+    if (indice < 0 || indice >= total) return total;
+    char nome[sizeof((*lista)->nome)];
+    memcpy(nome, (*lista)[indice].nome, sizeof(nome));
+    travarLista(p);
+    total = sincronizarMentorados(lista, total);
+    if (indice >= total || strcmp((*lista)[indice].nome, nome) != 0) {
+        for (indice = 0; indice < total; indice++) {
+            if (registroAtivo(p, indice) && strcmp((*lista)[indice].nome, nome) == 0) break;
+        }
+    }
+    if (indice < total && registroAtivo(p, indice)) {
+        marcarRemovido(p, indice);
+        registrarNoLog(p, "-;%d", indice);
+        total = verificarCompactacaoMentorados(*lista, total);
+    }
+    destravarLista(p);
+    return total;
+}
+
+// RANQUEAMENTO LOCAL
+
+int ehStopword(const char *t) {
+    static const char *stopwords[] = {
+        "a", "o", "e", "as", "os", "de", "da", "do", "das", "dos", "em", "na", "no", "nas", "nos",
+        "um", "uma", "para", "por", "com", "seu", "sua", "meu", "minha", "que", "ao", "the", "and", NULL
+    };
+    for (int i = 0; stopwords[i]; i++) if (strcmp(t, stopwords[i]) == 0) return 1;
+    return 0;
+}
+
+// Quebra o texto em termos normalizados. Áreas com várias palavras também
+// geram a sigla ("Inteligência Artificial" -> "ia").
+int tokenizar(const char *texto, char tokens[][TAM_TOKEN], int max, int gerar_sigla) {
+    char normal[512];
+    char sigla[TAM_TOKEN];
+    int n = 0, tam_sigla = 0;
+    normalizarTexto(texto, normal, sizeof(normal));
+    for (char *p = normal; *p && n < max; ) {
+        while (*p && !isalnum((unsigned char)*p)) p++;
+        char *inicio = p;
+        while (isalnum((unsigned char)*p)) p++;
+        int len = (int)(p - inicio);
+        if (len == 0) break;
+        if (len >= TAM_TOKEN) len = TAM_TOKEN - 1;
+        char termo[TAM_TOKEN];
+        memcpy(termo, inicio, len);
+        termo[len] = '\0';
+        if (ehStopword(termo)) continue;
+        if (tam_sigla < TAM_TOKEN - 1) sigla[tam_sigla++] = termo[0];
+        if (len < 2) continue;
+        strcpy(tokens[n++], termo);
+    }
+    if (gerar_sigla && tam_sigla >= 2 && n < max) {
+        sigla[tam_sigla] = '\0';
+        strcpy(tokens[n++], sigla);
+    }
+    return n;
+}
+
+// Peso da correspondência entre dois termos: exata, um contém o outro
+// ("seguranca"/"ciberseguranca") ou radical comum de 5+ letras
+double pesoCorrespondencia(const char *a, const char *b) {
+    if (strcmp(a, b) == 0) return 1.0;
+    size_t la = strlen(a), lb = strlen(b);
+    if (la >= 4 && lb >= 4 && (strstr(a, b) || strstr(b, a))) return 0.7;
+    size_t comum = 0;
+    while (a[comum] && a[comum] == b[comum]) comum++;
+    return comum >= 5 ? 0.5 : 0.0;
+}
+
+// Insere o mentor 'i' entre os k melhores de 'saida' (ordem decrescente;
+// empate: menor índice), se ele couber
+void inserirCandidato(CandidatoMentor *saida, int *n, int k, int i, double pontuacao) {
+    if (*n == k && (saida[k - 1].pontuacao > pontuacao ||
+                    (saida[k - 1].pontuacao == pontuacao && saida[k - 1].indice < i))) return;
+    int j = (*n < k) ? (*n)++ : k - 1;
+    while (j > 0 && (saida[j - 1].pontuacao < pontuacao ||
+                     (saida[j - 1].pontuacao == pontuacao && saida[j - 1].indice > i))) {
+        saida[j] = saida[j - 1];
+        j--;
+    }
+    saida[j].indice = i;
+    saida[j].pontuacao = pontuacao;
+    saida[j].motivo[0] = '\0';
+}
+
+// Parte textual da pontuação para cada área do índice: TF-IDF dos termos da
+// consulta, normalizado pelo número de termos da área (0 nas posições vazias).
+// 'pesos' (grupos x termos) recebe a melhor correspondência de cada termo.
+void pontuarAreas(const Mentor *mentores, int total, char consulta[][TAM_TOKEN], int nq, double *pesos, double *tfidf) {
+    int ativos = totalAtivos(&persistencia_mentores, total);
+    int grupos = indice_areas.capacidade;
+    int df[MAX_TOKENS] = {0};
+
+    // 1ª passada: melhor correspondência de cada termo da consulta por área
+    for (int g = 0; g < grupos; g++) {
+        const GrupoArea *grupo = &indice_areas.grupos[g];
+        tfidf[g] = 0.0;
+        if (!grupo->chave || grupo->ativos == 0) continue;
+        char area[MAX_TOKENS][TAM_TOKEN];
+        int na = tokenizar(mentores[grupo->ids[0]].area, area, MAX_TOKENS, 1);  // mesma chave: mesmos termos
+        tfidf[g] = na;  // guardado até a 2ª passada
+        for (int q = 0; q < nq; q++) {
+            double melhor = 0.0;
+            for (int t = 0; t < na; t++) {
+                double w = pesoCorrespondencia(consulta[q], area[t]);
+                if (w > melhor) melhor = w;
+            }
+            pesos[(size_t)g * nq + q] = melhor;
+            if (melhor > 0) df[q] += grupo->ativos;
+        }
+    }
+
+    // 2ª passada: soma ponderada pelo IDF
+    for (int g = 0; g < grupos; g++) {
+        double termos_area = tfidf[g], soma = 0.0;
+        if (termos_area == 0) continue;
+        for (int q = 0; q < nq; q++) {
+            double w = pesos[(size_t)g * nq + q];
+            if (w > 0) soma += w * (log((ativos + 1.0) / (df[q] + 1.0)) + 1.0);
+        }
+        tfidf[g] = soma / sqrt(termos_area);
+    }
+}
+
+// Bônus de experiência do mentor (atinge PESO_EXPERIENCIA com 30 anos)
+double bonusExperiencia(const Mentor *m) {
+    int xp = m->experiencia < 0 ? 0 : (m->experiencia > 30 ? 30 : m->experiencia);
+    return PESO_EXPERIENCIA * xp / 30.0;
+}
+
+// Termos do objetivo encontrados na área do mentor, separados por vírgula
+void motivoDoPar(const Mentor *mentor, const Mentorado *mentorado, char *motivo, size_t tamanho) {
+    char consulta[MAX_TOKENS][TAM_TOKEN];
+    char area[MAX_TOKENS][TAM_TOKEN];
+    int nq = tokenizar(mentorado->objetivo, consulta, MAX_TOKENS, 0);
+    int na = tokenizar(mentor->area, area, MAX_TOKENS, 1);
+    size_t usado = 0;
+    motivo[0] = '\0';
+    for (int q = 0; q < nq; q++) {
+        int encontrado = 0;
+        for (int t = 0; t < na && !encontrado; t++) encontrado = pesoCorrespondencia(consulta[q], area[t]) > 0;
+        if (!encontrado) continue;
+        int escrito = snprintf(motivo + usado, tamanho - usado, "%s%s", usado ? ", " : "", consulta[q]);
+        if (escrito < 0 || usado + escrito >= tamanho) break;
+        usado += escrito;
+    }
+}
+
+// Pontua todos os mentores para o objetivo do mentorado (TF-IDF dos termos do
+// objetivo sobre as áreas + bônus de experiência) e devolve os k melhores em
+// ordem decrescente. Retorna quantos candidatos foram preenchidos.
+// A parte textual é calculada uma vez por área do índice, não por mentor.
+int preRanquearMentores(const Mentor *mentores, int total, const Mentorado *mentorado, CandidatoMentor *saida, int k) {
+    char consulta[MAX_TOKENS][TAM_TOKEN];
+    int nq = tokenizar(mentorado->objetivo, consulta, MAX_TOKENS, 0);
+    if (total <= 0 || k <= 0) return 0;
+    if (indice_areas.total_ids != total) reconstruirIndiceAreas(mentores, total);
+    int grupos = indice_areas.capacidade;
+    double *pesos = calloc((size_t)grupos * (nq ? nq : 1), sizeof(double));
+    double *tfidf = calloc(grupos, sizeof(double));
+    if (!pesos || !tfidf) {
+        free(pesos);
+        free(tfidf);
+        return 0;
+    }
+    pontuarAreas(mentores, total, consulta, nq, pesos, tfidf);
+
+    // Pontuação final e seleção dos k melhores (empate: menor índice)
+    int n = 0;
+    for (int g = 0; g < grupos; g++) {
+        const GrupoArea *grupo = &indice_areas.grupos[g];
+        if (!grupo->chave || grupo->ativos == 0) continue;
+        for (int m = 0; m < grupo->total; m++) {
+            int i = grupo->ids[m];
+            if (!registroAtivo(&persistencia_mentores, i)) continue;
+            inserirCandidato(saida, &n, k, i, tfidf[g] + bonusExperiencia(&mentores[i]));
+        }
+    }
+
+    // Motivo só para os escolhidos
+    for (int c = 0; c < n; c++) motivoDoPar(&mentores[saida[c].indice], mentorado, saida[c].motivo, sizeof(saida[c].motivo));
+    free(pesos);
+    free(tfidf);
+    return n;
+}
+
+// Texto da recomendação local, usado quando o modelo não responde
+char* recomendacaoLocal(const Mentor *mentores, const Mentorado *mentorado, const CandidatoMentor *candidatos, int total) {
+    size_t tamanho = 512 + (size_t)total * 400;
+    char *texto = malloc(tamanho);
+    if (!texto) return NULL;
+    size_t usado = (size_t)snprintf(texto, tamanho, "Recomendação local (modelo indisponível) para %s:\n\n", mentorado->nome);
+    for (int i = 0; i < total && i < 3; i++) {
+        const Mentor *m = &mentores[candidatos[i].indice];
+        usado += (size_t)snprintf(texto + usado, tamanho - usado, "%d) %s — %s, %d anos XP (pontuação %.2f)\n   Termos em comum: %s\n",
+                                  candidatos[i].indice + 1, m->nome, m->area, m->experiencia, candidatos[i].pontuacao,
+                                  candidatos[i].motivo[0] ? candidatos[i].motivo : "nenhum (escolhido pela experiência)");
+        if (usado >= tamanho) break;
+    }
+    return texto;
+}
+
+// SIMILARIDADE VETORIAL
+
+// Alternativa totalmente local ao modelo: área e objetivo viram vetores de
+// termos e trigramas de caracteres com hashing (DIM_VETOR posições, sinal
+// pelo hash), normalizados, e a pontuação é o cosseno (produto escalar).
+
+typedef float (*KernelProduto)(const float *a, const float *b);
+
+KernelProduto kernel_produto = NULL;     // escolhido na primeira busca
+const char *nome_kernel_produto = "";
+
+float produtoEscalarPortavel(const float *a, const float *b) {
+    float soma[4] = {0, 0, 0, 0};
+    for (int i = 0; i < DIM_VETOR; i += 4) {
+        for (int j = 0; j < 4; j++) soma[j] += a[i + j] * b[i + j];
+    }
+    return (soma[0] + soma[2]) + (soma[1] + soma[3]);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2")))
+float produtoEscalarSse(const float *a, const float *b) {
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    for (int i = 0; i < DIM_VETOR; i += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_load_ps(a + i), _mm_load_ps(b + i)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_load_ps(a + i + 4), _mm_load_ps(b + i + 4)));
+    }
+    __m128 s = _mm_add_ps(s0, s1);
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx2,fma")))
+float produtoEscalarAvx2(const float *a, const float *b) {
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    for (int i = 0; i < DIM_VETOR; i += 16) {
+        s0 = _mm256_fmadd_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i), s0);
+        s1 = _mm256_fmadd_ps(_mm256_load_ps(a + i + 8), _mm256_load_ps(b + i + 8), s1);
+    }
+    __m256 s8 = _mm256_add_ps(s0, s1);
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(s8), _mm256_extractf128_ps(s8, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+#endif
+
+// Melhor kernel disponível na CPU em execução
+KernelProduto escolherKernel(const char **nome) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        *nome = "AVX2";
+        return produtoEscalarAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        *nome = "SSE";
+        return produtoEscalarSse;
+    }
+#endif
+    *nome = "escalar";
+    return produtoEscalarPortavel;
+}
+
+void acumularTermo(float *v, const char *termo, float peso) {
+    uint64_t h = hashTexto(termo);
+    v[h & (DIM_VETOR - 1)] += (h >> 63) ? -peso : peso;
+}
+
+// Vetor normalizado do texto: cada termo e seus trigramas com marcas de
+// início/fim, que aproximam "seguranca" de "ciberseguranca" e "jogo" de "jogos"
+void vetorizarTexto(const char *texto, int gerar_sigla, float *v) {
+    char termos[MAX_TOKENS][TAM_TOKEN];
+    int n = tokenizar(texto, termos, MAX_TOKENS, gerar_sigla);
+    memset(v, 0, DIM_VETOR * sizeof(float));
+    for (int t = 0; t < n; t++) {
+        acumularTermo(v, termos[t], 1.0f);
+        char marcado[TAM_TOKEN + 2];
+        int len = snprintf(marcado, sizeof(marcado), "^%s$", termos[t]);
+        for (int i = 0; i + 3 <= len; i++) {
+            char trigrama[5] = { '#', marcado[i], marcado[i + 1], marcado[i + 2], '\0' };
+            acumularTermo(v, trigrama, 1.0f);
+        }
+    }
+    float norma = 0.0f;
+    for (int i = 0; i < DIM_VETOR; i++) norma += v[i] * v[i];
+    if (norma > 0.0f) {
+        norma = 1.0f / sqrtf(norma);
+        for (int i = 0; i < DIM_VETOR; i++) v[i] *= norma;
+    }
+}
+
+int reservarLinhaVetor(MatrizVetores *m) {
+    if (m->linhas == m->capacidade) {
+        int nova = m->capacidade ? m->capacidade * 2 : 64;
+        float *dados = aligned_alloc(32, (size_t)nova * DIM_VETOR * sizeof(float));
+        if (!dados) return -1;
+        if (m->dados) memcpy(dados, m->dados, (size_t)m->linhas * DIM_VETOR * sizeof(float));
+        free(m->dados);
+        m->dados = dados;
+        m->capacidade = nova;
+    }
+    return m->linhas++;
+}
+
+// Vetoriza só as áreas novas; remoções já se refletem em grupo->ativos
+int atualizarVetoresAreas(const Mentor *mentores, int total) {
+    if (indice_areas.total_ids != total) reconstruirIndiceAreas(mentores, total);
+    for (int g = 0; g < indice_areas.capacidade; g++) {
+        GrupoArea *grupo = &indice_areas.grupos[g];
+        if (!grupo->chave || grupo->linha >= 0) continue;
+        int linha = reservarLinhaVetor(&vetores_areas);
+        if (linha < 0) return 0;
+        vetorizarTexto(grupo->chave, 1, vetores_areas.dados + (size_t)linha * DIM_VETOR);
+        grupo->linha = linha;
+    }
+    return 1;
+}
+
+// Os k mentores mais próximos do objetivo (cosseno + bônus de experiência).
+// Retorna quantos candidatos foram preenchidos.
+int ranquearPorSimilaridade(const Mentor *mentores, int total, const Mentorado *mentorado, CandidatoMentor *saida, int k) {
+    if (!kernel_produto) kernel_produto = escolherKernel(&nome_kernel_produto);
+    if (total <= 0 || k <= 0 || !atualizarVetoresAreas(mentores, total)) return 0;
+
+    float *consulta = aligned_alloc(32, DIM_VETOR * sizeof(float));
+    float *similaridade = malloc(((size_t)vetores_areas.linhas + 1) * sizeof(float));
+    if (!consulta || !similaridade) {
+        free(consulta);
+        free(similaridade);
+        return 0;
+    }
+    vetorizarTexto(mentorado->objetivo, 0, consulta);
+    // Percorre a matriz em ordem: uma linha por área, acesso sequencial
+    const float *linha = vetores_areas.dados;
+    for (int l = 0; l < vetores_areas.linhas; l++, linha += DIM_VETOR) similaridade[l] = kernel_produto(consulta, linha);
+
+    int n = 0;
+    for (int g = 0; g < indice_areas.capacidade; g++) {
+        const GrupoArea *grupo = &indice_areas.grupos[g];
+        if (!grupo->chave || grupo->ativos == 0) continue;
+        double sim = similaridade[grupo->linha];
+        // Nem o mentor mais experiente da área entraria entre os k
+        if (n == k && sim + PESO_EXPERIENCIA_SIMILARIDADE < saida[k - 1].pontuacao) continue;
+        for (int m = 0; m < grupo->total; m++) {
+            int i = grupo->ids[m];
+            if (!registroAtivo(&persistencia_mentores, i)) continue;
+            int xp = mentores[i].experiencia < 0 ? 0 : (mentores[i].experiencia > 30 ? 30 : mentores[i].experiencia);
+            inserirCandidato(saida, &n, k, i, sim + PESO_EXPERIENCIA_SIMILARIDADE * xp / 30.0);
+        }
+    }
+    free(consulta);
+    free(similaridade);
+
+    // Motivo: termos do objetivo presentes (ou quase) na área
+    char objetivo[MAX_TOKENS][TAM_TOKEN];
+    int nq = tokenizar(mentorado->objetivo, objetivo, MAX_TOKENS, 0);
+    for (int c = 0; c < n; c++) {
+        char area[MAX_TOKENS][TAM_TOKEN];
+        int na = tokenizar(mentores[saida[c].indice].area, area, MAX_TOKENS, 1);
+        size_t usado = 0;
+        for (int q = 0; q < nq; q++) {
+            int casa = 0;
+            for (int t = 0; t < na && !casa; t++) casa = pesoCorrespondencia(objetivo[q], area[t]) > 0;
+            if (!casa) continue;
+            int escrito = snprintf(saida[c].motivo + usado, sizeof(saida[c].motivo) - usado, "%s%s", usado ? ", " : "", objetivo[q]);
+            if (escrito < 0 || usado + escrito >= sizeof(saida[c].motivo)) break;
+            usado += escrito;
+        }
+    }
+    return n;
+}
+
+// MÉTRICAS DAS REQUISIÇÕES
+
+FILE *arquivo_metricas = NULL;
+
+long agoraMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+// Como agoraMs, com fração: para medir trechos curtos (montagem, interpretação)
+double cronometroMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Anexa uma linha com os tempos da transferência que 'curl' acabou de fazer.
+// Cada tentativa é registrada separadamente.
+void registrarMetrica(CURL *curl, CURLcode res, long http_code, const char *origem, int tentativa,
+                      double montagem_ms, double interpretacao_ms) {
+    if (!arquivo_metricas) {
+        arquivo_metricas = fopen(ARQ_METRICAS, "a");
+        if (!arquivo_metricas) return;
+        if (ftell(arquivo_metricas) == 0) {
+            fprintf(arquivo_metricas, "# data;origem;tentativa;resultado;http;dns_ms;conexao_ms;tls_ms;"
+                                      "primeiro_byte_ms;total_ms;bytes_enviados;bytes_recebidos;montagem_ms;interpretacao_ms\n");
+        }
+    }
+    curl_off_t dns = 0, conexao = 0, tls = 0, primeiro_byte = 0, total = 0, enviados = 0, recebidos = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &conexao);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &primeiro_byte);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &enviados);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &recebidos);
+
+    char data[32];
+    time_t agora = time(NULL);
+    strftime(data, sizeof(data), "%Y-%m-%dT%H:%M:%S", localtime(&agora));
+    // Os tempos do cURL vêm em microssegundos
+    fprintf(arquivo_metricas, "%s;%s;%d;%d;%ld;%.3f;%.3f;%.3f;%.3f;%.3f;%ld;%ld;%.3f;%.3f\n",
+            data, origem, tentativa, (int)res, http_code, dns / 1000.0, conexao / 1000.0, tls / 1000.0,
+            primeiro_byte / 1000.0, total / 1000.0, (long)enviados, (long)recebidos, montagem_ms, interpretacao_ms);
+    fflush(arquivo_metricas);
+}
+
+void encerrarMetricas() {
+    if (arquivo_metricas) fclose(arquivo_metricas);
+    arquivo_metricas = NULL;
+}
+
+int compararDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil pelo método do posto mais próximo; 'valores' já ordenado
+double percentil(const double *valores, int total, double p) {
+    int posto = (int)ceil(p / 100.0 * total);
+    if (posto < 1) posto = 1;
+    return valores[posto - 1];
+}
+
+// Mostra p50/p95/p99 de cada coluna de metricas_gemini.log
+void mostrarResumoMetricas() {
+    FILE *f = fopen(ARQ_METRICAS, "r");
+    AmostraMetrica *amostras = NULL;
+    int total = 0, capacidade = 0, sucesso = 0, limite = 0;
+    char linha[512];
+    while (f && fgets(linha, sizeof(linha), f)) {
+        AmostraMetrica a;
+        if (linha[0] == '#') continue;
+        if (sscanf(linha, "%*[^;];%*[^;];%*d;%d;%ld;%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf",
+                   &a.resultado, &a.http_code, &a.dns, &a.conexao, &a.tls, &a.primeiro_byte, &a.total,
+                   &a.enviados, &a.recebidos, &a.montagem, &a.interpretacao) != 11) continue;
+        if (!reservarLista((void **)&amostras, total, &capacidade, sizeof(AmostraMetrica))) break;
+        amostras[total++] = a;
+        if (a.resultado == CURLE_OK && a.http_code == 200) sucesso++;
+        if (a.http_code == 429) limite++;
+    }
+    if (f) fclose(f);
+
+    print_border_top();
+    print_line("Métricas das Requisições ao Modelo (" ARQ_METRICAS "):");
+    print_line("");
+    if (total == 0) {
+        print_line("Nenhuma requisição registrada.");
+        print_border_bottom();
+        free(amostras);
+        return;
+    }
+    char buffer[200];
+    snprintf(buffer, sizeof(buffer), "Requisições: %d (sucesso: %d, 429: %d, outros erros: %d)", total, sucesso, limite, total - sucesso - limite);
+    print_line(buffer);
+    print_line("");
+    snprintf(buffer, sizeof(buffer), "%-20s %10s %10s %10s", "", "p50", "p95", "p99");
+    print_line(buffer);
+
+    static const struct { const char *nome; size_t campo; int casas; } colunas[] = {
+        { "DNS (ms)",            offsetof(AmostraMetrica, dns), 2 },
+        { "Conexão (ms)",        offsetof(AmostraMetrica, conexao), 2 },
+        { "TLS (ms)",            offsetof(AmostraMetrica, tls), 2 },
+        { "Primeiro byte (ms)",  offsetof(AmostraMetrica, primeiro_byte), 2 },
+        { "Total (ms)",          offsetof(AmostraMetrica, total), 2 },
+        { "Montagem (ms)",       offsetof(AmostraMetrica, montagem), 2 },
+        { "Interpretação (ms)",  offsetof(AmostraMetrica, interpretacao), 2 },
+        { "Enviados (bytes)",    offsetof(AmostraMetrica, enviados), 0 },
+        { "Recebidos (bytes)",   offsetof(AmostraMetrica, recebidos), 0 },
+    };
+    double *valores = malloc(total * sizeof(double));
+    for (size_t c = 0; valores && c < sizeof(colunas) / sizeof(colunas[0]); c++) {
+        for (int i = 0; i < total; i++) valores[i] = *(const double *)((const char *)&amostras[i] + colunas[c].campo);
+        qsort(valores, total, sizeof(double), compararDouble);
+        char nome[40];
+        // Alinhamento pelo número de caracteres, não de bytes (acentos)
+        snprintf(nome, sizeof(nome), "%s%*s", colunas[c].nome, 20 - visual_width(colunas[c].nome), "");
+        int casas = colunas[c].casas;
+        snprintf(buffer, sizeof(buffer), "%s %10.*f %10.*f %10.*f", nome, casas, percentil(valores, total, 50),
+                 casas, percentil(valores, total, 95), casas, percentil(valores, total, 99));
+        print_line(buffer);
+    }
+    print_border_bottom();
+    free(valores);
+    free(amostras);
+}
+
+// ATRIBUIÇÃO GLOBAL COM VAGAS
+// Escolhe um mentor para cada mentorado de uma vez, sem passar das vagas de
+// cada mentor, com fluxo máximo de custo mínimo. Como a pontuação é a parte
+// textual (por área) mais o bônus de experiência (por mentor), a rede passa
+// pelas áreas: origem -> mentorado -> área -> destino, com uma aresta por
+// mentor entre a área e o destino (capacidade = vagas). Cada mentorado liga às
+// suas AREAS_ATRIBUICAO melhores áreas e a um nó "qualquer área" (parte
+// textual zero), então todos os mentores continuam alcançáveis. Os custos são
+// as pontuações invertidas: o fluxo máximo atende o maior número possível de
+// mentorados e, entre essas soluções, maximiza a soma das pontuações.
+
+int iniciarRede(RedeFluxo *rede, int nos, int arestas) {
+    memset(rede, 0, sizeof(*rede));
+    rede->destino = malloc((size_t)arestas * sizeof(int));
+    rede->capacidade = malloc((size_t)arestas * sizeof(int));
+    rede->custo = malloc((size_t)arestas * sizeof(int));
+    rede->proxima = malloc((size_t)arestas * sizeof(int));
+    rede->primeira = malloc((size_t)nos * sizeof(int));
+    rede->total_nos = nos;
+    if (!rede->destino || !rede->capacidade || !rede->custo || !rede->proxima || !rede->primeira) return 0;
+    for (int v = 0; v < nos; v++) rede->primeira[v] = -1;
+    return 1;
+}
+
+void liberarRede(RedeFluxo *rede) {
+    free(rede->destino);
+    free(rede->capacidade);
+    free(rede->custo);
+    free(rede->proxima);
+    free(rede->primeira);
+    memset(rede, 0, sizeof(*rede));
+}
+
+// Aresta de -> para e sua reversa (capacidade 0, custo oposto); o espaço já
+// foi reservado por iniciarRede
+void adicionarAresta(RedeFluxo *rede, int de, int para, int capacidade, int custo) {
+    int a = rede->total_arestas;
+    rede->destino[a] = para;
+    rede->capacidade[a] = capacidade;
+    rede->custo[a] = custo;
+    rede->proxima[a] = rede->primeira[de];
+    rede->primeira[de] = a;
+    rede->destino[a + 1] = de;
+    rede->capacidade[a + 1] = 0;
+    rede->custo[a + 1] = -custo;
+    rede->proxima[a + 1] = rede->primeira[para];
+    rede->primeira[para] = a + 1;
+    rede->total_arestas += 2;
+}
+
+void subirHeap(ItemHeap *heap, int i) {
+    ItemHeap item = heap[i];
+    while (i > 0 && heap[(i - 1) / 2].distancia > item.distancia) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = item;
+}
+
+void descerHeap(ItemHeap *heap, int total, int i) {
+    ItemHeap item = heap[i];
+    while (2 * i + 1 < total) {
+        int f = 2 * i + 1;
+        if (f + 1 < total && heap[f + 1].distancia < heap[f].distancia) f++;
+        if (heap[f].distancia >= item.distancia) break;
+        heap[i] = heap[f];
+        i = f;
+    }
+    heap[i] = item;
+}
+
+// Dijkstra sobre os custos reduzidos (custo + potencial[u] - potencial[v],
+// nunca negativos), parando ao retirar o destino. Os potenciais avançam pela
+// distância de cada nó finalizado e pela do destino nos demais, o que mantém
+// os custos reduzidos não negativos. Retorna 0 se o destino é inalcançável.
+int atualizarPotenciais(const RedeFluxo *rede, int origem, int destino, long long *potencial, long long *distancia,
+                        char *finalizado, ItemHeap *heap) {
+    for (int v = 0; v < rede->total_nos; v++) {
+        distancia[v] = LLONG_MAX;
+        finalizado[v] = 0;
+    }
+    int total = 0;
+    distancia[origem] = 0;
+    heap[total++] = (ItemHeap){0, origem};
+    while (total > 0) {
+        ItemHeap topo = heap[0];
+        heap[0] = heap[--total];
+        descerHeap(heap, total, 0);
+        int u = topo.no;
+        if (finalizado[u]) continue;
+        finalizado[u] = 1;
+        if (u == destino) break;
+        for (int a = rede->primeira[u]; a != -1; a = rede->proxima[a]) {
+            int v = rede->destino[a];
+            if (rede->capacidade[a] <= 0 || finalizado[v]) continue;
+            long long d = topo.distancia + rede->custo[a] + potencial[u] - potencial[v];
+            if (d < distancia[v]) {
+                distancia[v] = d;
+                heap[total] = (ItemHeap){d, v};
+                subirHeap(heap, total++);
+            }
+        }
+    }
+    if (!finalizado[destino]) return 0;
+    for (int v = 0; v < rede->total_nos; v++) {
+        potencial[v] += finalizado[v] ? distancia[v] : distancia[destino];
+    }
+    return 1;
+}
+
+// Aresta admissível: tem capacidade e custo reduzido zero (está num caminho mínimo)
+int arestaAdmissivel(const RedeFluxo *rede, const long long *potencial, int u, int a) {
+    return rede->capacidade[a] > 0 && rede->custo[a] + potencial[u] - potencial[rede->destino[a]] == 0;
+}
+
+// Níveis (BFS) da origem no subgrafo admissível; retorna se o destino foi alcançado
+int nivelarAdmissiveis(const RedeFluxo *rede, const long long *potencial, int origem, int destino, int *nivel, int *fila) {
+    for (int v = 0; v < rede->total_nos; v++) nivel[v] = -1;
+    int inicio = 0, fim = 0;
+    nivel[origem] = 0;
+    fila[fim++] = origem;
+    while (inicio < fim) {
+        int u = fila[inicio++];
+        for (int a = rede->primeira[u]; a != -1; a = rede->proxima[a]) {
+            int v = rede->destino[a];
+            if (nivel[v] != -1 || !arestaAdmissivel(rede, potencial, u, a)) continue;
+            nivel[v] = nivel[u] + 1;
+            fila[fim++] = v;
+        }
+    }
+    return nivel[destino] != -1;
+}
+
+// Fluxo bloqueante (Dinic) nos níveis atuais, com busca iterativa: caminhos
+// alternados podem ser longos demais para recursão. Todo caminho leva uma
+// unidade, pois as arestas da origem têm capacidade 1. Retorna o fluxo enviado.
+int fluxoBloqueante(RedeFluxo *rede, const long long *potencial, int origem, int destino, int *nivel, int *atual, int *caminho) {
+    int enviado = 0, tamanho = 0, u = origem;
+    for (int v = 0; v < rede->total_nos; v++) atual[v] = rede->primeira[v];
+    while (1) {
+        if (u == destino) {
+            for (int i = 0; i < tamanho; i++) {
+                rede->capacidade[caminho[i]]--;
+                rede->capacidade[caminho[i] ^ 1]++;
+            }
+            enviado++;
+            tamanho = 0;
+            u = origem;
+            continue;
+        }
+        int a = atual[u];
+        while (a != -1 && !(nivel[rede->destino[a]] == nivel[u] + 1 && arestaAdmissivel(rede, potencial, u, a))) a = rede->proxima[a];
+        atual[u] = a;
+        if (a != -1) {
+            caminho[tamanho++] = a;
+            u = rede->destino[a];
+            continue;
+        }
+        // Sem saída: o nó não serve mais nesta fase; volta uma aresta
+        nivel[u] = -1;
+        if (u == origem) break;
+        a = caminho[--tamanho];
+        u = rede->destino[a ^ 1];
+        atual[u] = rede->proxima[a];
+    }
+    return enviado;
+}
+
+// Fluxo máximo de custo mínimo da origem ao destino. Cada fase calcula os
+// caminhos mínimos uma vez e satura todos os de mesmo custo. Retorna o fluxo.
+int fluxoCustoMinimo(RedeFluxo *rede, int origem, int destino) {
+    int n = rede->total_nos;
+    long long *potencial = calloc(n, sizeof(long long));
+    long long *distancia = malloc((size_t)n * sizeof(long long));
+    char *finalizado = malloc(n);
+    ItemHeap *heap = malloc(((size_t)rede->total_arestas + n) * sizeof(ItemHeap));
+    int *nivel = malloc((size_t)n * sizeof(int));
+    int *fila = malloc((size_t)n * sizeof(int));
+    int *atual = malloc((size_t)n * sizeof(int));
+    int *caminho = malloc((size_t)n * sizeof(int));
+    int fluxo = -1;
+    if (potencial && distancia && finalizado && heap && nivel && fila && atual && caminho) {
+        fluxo = 0;
+        while (atualizarPotenciais(rede, origem, destino, potencial, distancia, finalizado, heap)) {
+            while (nivelarAdmissiveis(rede, potencial, origem, destino, nivel, fila)) {
+                fluxo += fluxoBloqueante(rede, potencial, origem, destino, nivel, atual, caminho);
+            }
+        }
+    }
+    free(potencial);
+    free(distancia);
+    free(finalizado);
+    free(heap);
+    free(nivel);
+    free(fila);
+    free(atual);
+    free(caminho);
+    return fluxo;
+}
+
+void liberarAtribuicao(AtribuicaoMentores *a) {
+    free(a->mentor);
+    free(a->pontuacao);
+    memset(a, 0, sizeof(*a));
+}
+
+// Atribui mentores a todos os mentorados ativos. Mentores sem 'vagas' próprio
+// aceitam 'vagas_padrao'. Retorna 0 se faltar memória.
+int atribuirMentores(const Mentor *mentores, int totalMentores, const Mentorado *mentorados, int totalMentorados,
+                     int vagas_padrao, AtribuicaoMentores *a) {
+    memset(a, 0, sizeof(*a));
+    a->mentores = mentores;
+    a->mentorados = mentorados;
+    a->mais_procurado = -1;
+    if (indice_areas.total_ids != totalMentores) reconstruirIndiceAreas(mentores, totalMentores);
+    int grupos = indice_areas.capacidade;
+    int k = AREAS_ATRIBUICAO;
+    int peso_bonus = (int)lround(PESO_EXPERIENCIA * 1000.0);
+    a->mentor = malloc(((size_t)totalMentorados + 1) * sizeof(int));
+    a->pontuacao = calloc((size_t)totalMentorados + 1, sizeof(double));
+    int *par_area = malloc(((size_t)totalMentorados * k + 1) * sizeof(int));
+    int *par_peso = malloc(((size_t)totalMentorados * k + 1) * sizeof(int));
+    int *pares = calloc((size_t)totalMentorados + 1, sizeof(int));
+    double *pesos = malloc(((size_t)grupos * MAX_TOKENS + 1) * sizeof(double));
+    double *tfidf = malloc(((size_t)grupos + 1) * sizeof(double));
+    int *melhor_da_area = malloc(((size_t)grupos + 1) * sizeof(int));  // mentor de maior bônus
+    int *demanda = calloc((size_t)totalMentores + 1, sizeof(int));
+    int *restante = malloc(((size_t)grupos + 1) * sizeof(int));
+    int *proximo_mentor = malloc(((size_t)grupos + 1) * sizeof(int));   // posição em grupo->ids
+    int *aresta_mentor = malloc(((size_t)totalMentores + 1) * sizeof(int));
+    CandidatoMentor melhores[AREAS_ATRIBUICAO];
+    RedeFluxo rede = {0};
+    int ok = a->mentor && a->pontuacao && par_area && par_peso && pares && pesos && tfidf && melhor_da_area &&
+             demanda && restante && proximo_mentor && aresta_mentor;
+
+    for (int g = 0; ok && g < grupos; g++) {
+        const GrupoArea *grupo = &indice_areas.grupos[g];
+        melhor_da_area[g] = -1;
+        for (int m = 0; grupo->chave && m < grupo->total; m++) {
+            int i = grupo->ids[m];
+            if (!registroAtivo(&persistencia_mentores, i)) continue;
+            if (melhor_da_area[g] < 0 || mentores[i].experiencia > mentores[melhor_da_area[g]].experiencia) melhor_da_area[g] = i;
+        }
+    }
+
+    // Áreas de cada mentorado (pesos inteiros, em milésimos, para o fluxo)
+    double inicio = cronometroMs();
+    int peso_maximo = 0, total_pares = 0;
+    for (int i = 0; ok && i < totalMentorados; i++) {
+        a->mentor[i] = -1;
+        if (!registroAtivo(&persistencia_mentorados, i)) continue;
+        char consulta[MAX_TOKENS][TAM_TOKEN];
+        int nq = tokenizar(mentorados[i].objetivo, consulta, MAX_TOKENS, 0);
+        pontuarAreas(mentores, totalMentores, consulta, nq, pesos, tfidf);
+        int n = 0, preferido = -1;
+        double melhor = -1.0;
+        for (int g = 0; g < grupos; g++) {
+            if (melhor_da_area[g] < 0) continue;
+            if (tfidf[g] > 0) inserirCandidato(melhores, &n, k, g, tfidf[g]);
+            double sem_limite = tfidf[g] + bonusExperiencia(&mentores[melhor_da_area[g]]);
+            if (sem_limite > melhor) {
+                melhor = sem_limite;
+                preferido = melhor_da_area[g];
+            }
+        }
+        for (int c = 0; c < n; c++) {
+            int peso = (int)lround(melhores[c].pontuacao * 1000.0);
+            par_area[(size_t)i * k + c] = melhores[c].indice;
+            par_peso[(size_t)i * k + c] = peso;
+            if (peso > peso_maximo) peso_maximo = peso;
+        }
+        pares[i] = n;
+        total_pares += n;
+        if (preferido >= 0 && ++demanda[preferido] > a->maior_demanda) {
+            a->maior_demanda = demanda[preferido];
+            a->mais_procurado = preferido;
+        }
+    }
+    a->candidatos_ms = cronometroMs() - inicio;
+
+    // Nós: origem, mentorados, "qualquer área", áreas, destino
+    inicio = cronometroMs();
+    int origem = 0, qualquer = totalMentorados + 1, destino = totalMentorados + grupos + 2;
+    ok = ok && iniciarRede(&rede, destino + 1, 2 * (2 * totalMentorados + total_pares + grupos + totalMentores));
+    for (int i = 0; ok && i < totalMentorados; i++) {
+        if (!registroAtivo(&persistencia_mentorados, i)) continue;
+        adicionarAresta(&rede, origem, 1 + i, 1, 0);
+        adicionarAresta(&rede, 1 + i, qualquer, 1, peso_maximo);
+        for (int c = 0; c < pares[i]; c++) {
+            adicionarAresta(&rede, 1 + i, qualquer + 1 + par_area[(size_t)i * k + c], 1, peso_maximo - par_peso[(size_t)i * k + c]);
+        }
+    }
+    for (int g = 0; ok && g < grupos; g++) {
+        const GrupoArea *grupo = &indice_areas.grupos[g];
+        int vagas_area = 0;
+        for (int m = 0; melhor_da_area[g] >= 0 && m < grupo->total; m++) {
+            int i = grupo->ids[m];
+            if (!registroAtivo(&persistencia_mentores, i)) continue;
+            int vagas = mentores[i].vagas > 0 ? mentores[i].vagas : vagas_padrao;
+            aresta_mentor[i] = rede.total_arestas;
+            adicionarAresta(&rede, qualquer + 1 + g, destino, vagas, peso_bonus - (int)lround(bonusExperiencia(&mentores[i]) * 1000.0));
+            vagas_area += vagas;
+        }
+        if (vagas_area > 0) adicionarAresta(&rede, qualquer, qualquer + 1 + g, vagas_area, 0);
+    }
+    ok = ok && fluxoCustoMinimo(&rede, origem, destino) >= 0;
+
+    // Decomposição do fluxo: quanto cada área recebe pelo nó "qualquer área"
+    // e quantos mentorados cada mentor recebe (fluxo = capacidade da reversa)
+    for (int g = 0; ok && g < grupos; g++) {
+        restante[g] = 0;
+        proximo_mentor[g] = 0;
+    }
+    for (int e = ok ? rede.primeira[qualquer] : -1; e != -1; e = rede.proxima[e]) {
+        if (!(e & 1)) restante[rede.destino[e] - qualquer - 1] = rede.capacidade[e ^ 1];
+    }
+    memset(demanda, 0, ((size_t)totalMentores + 1) * sizeof(int));  // passa a marcar mentores usados
+    int area_qualquer = 0;
+    for (int i = 0; ok && i < totalMentorados; i++) {
+        if (!registroAtivo(&persistencia_mentorados, i)) continue;
+        int g = -1, peso_texto = 0;
+        for (int e = rede.primeira[1 + i]; e != -1 && g < 0; e = rede.proxima[e]) {
+            if ((e & 1) || rede.capacidade[e] != 0) continue;
+            if (rede.destino[e] != qualquer) {
+                g = rede.destino[e] - qualquer - 1;
+                peso_texto = peso_maximo - rede.custo[e];
+                continue;
+            }
+            while (area_qualquer < grupos && restante[area_qualquer] == 0) area_qualquer++;
+            if (area_qualquer == grupos) break;
+            g = area_qualquer;
+            restante[g]--;
+        }
+        if (g < 0) {
+            a->sem_vaga++;
+            continue;
+        }
+        // Próximo mentor da área com fluxo ainda não distribuído
+        const GrupoArea *grupo = &indice_areas.grupos[g];
+        int m = -1;
+        while (proximo_mentor[g] < grupo->total) {
+            int id = grupo->ids[proximo_mentor[g]];
+            if (registroAtivo(&persistencia_mentores, id) && rede.capacidade[aresta_mentor[id] ^ 1] > 0) {
+                m = id;
+                break;
+            }
+            proximo_mentor[g]++;
+        }
+        if (m < 0) {
+            a->sem_vaga++;
+            continue;
+        }
+        rede.capacidade[aresta_mentor[m] ^ 1]--;
+        a->mentor[i] = m;
+        a->pontuacao[i] = (peso_texto + peso_bonus - rede.custo[aresta_mentor[m]]) / 1000.0;
+        a->atribuidos++;
+        a->soma_pontuacao += a->pontuacao[i];
+        if (demanda[m]++ == 0) a->mentores_usados++;
+    }
+    a->fluxo_ms = cronometroMs() - inicio;
+    liberarRede(&rede);
+    free(par_area);
+    free(par_peso);
+    free(pares);
+    free(pesos);
+    free(tfidf);
+    free(melhor_da_area);
+    free(demanda);
+    free(restante);
+    free(proximo_mentor);
+    free(aresta_mentor);
+    return ok;
+}
+
+// FUNÇÕES DA API DO GEMINI
+
+// EXTRAÇÃO INCREMENTAL DA RESPOSTA
+
+enum { EXTRATOR_FORA, EXTRATOR_STRING, EXTRATOR_ESCAPE, EXTRATOR_UNICODE };
+
+void anexarUtf8(TextoDinamico *t, unsigned cp) {
+    char buf[4];
+    size_t n;
+    if (cp < 0x80) { buf[0] = (char)cp; n = 1; }
+    else if (cp < 0x800) { buf[0] = (char)(0xC0 | (cp >> 6)); buf[1] = (char)(0x80 | (cp & 0x3F)); n = 2; }
+    else if (cp < 0x10000) {
+        buf[0] = (char)(0xE0 | (cp >> 12)); buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (cp & 0x3F)); n = 3;
+    } else {
+        buf[0] = (char)(0xF0 | (cp >> 18)); buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F)); buf[3] = (char)(0x80 | (cp & 0x3F)); n = 4;
+    }
+    anexarTexto(t, buf, n);
+}
+
+// O valor em leitura está em candidates[0].content.parts[0].text?
+int caminhoDoTexto(const ExtratorTexto *e) {
+    const NivelJson *p = e->pilha;
+    return e->profundidade == 6 &&
+           p[0].tipo == '{' && strcmp(p[0].chave, "candidates") == 0 &&
+           p[1].tipo == '[' && p[1].indice == 0 &&
+           p[2].tipo == '{' && strcmp(p[2].chave, "content") == 0 &&
+           p[3].tipo == '{' && strcmp(p[3].chave, "parts") == 0 &&
+           p[4].tipo == '[' && p[4].indice == 0 &&
+           p[5].tipo == '{' && strcmp(p[5].chave, "text") == 0;
+}
+
+void caractereExtraido(ExtratorTexto *e, char c) {
+    if (e->capturando) {
+        anexarTexto(&e->texto, &c, 1);
+    } else if (e->eh_chave && e->profundidade <= PROFUNDIDADE_JSON && e->tam_chave < (int)sizeof(e->pilha[0].chave) - 1) {
+        NivelJson *nivel = &e->pilha[e->profundidade - 1];
+        nivel->chave[e->tam_chave++] = c;
+        nivel->chave[e->tam_chave] = '\0';
+    }
+}
+
+void alimentarExtrator(ExtratorTexto *e, const char *dados, size_t tamanho) {
+    NivelJson *topo = (e->profundidade > 0 && e->profundidade <= PROFUNDIDADE_JSON) ? &e->pilha[e->profundidade - 1] : NULL;
+    for (size_t i = 0; i < tamanho; i++) {
+        char c = dados[i];
+        switch (e->estado) {
+            case EXTRATOR_FORA:
+                if (c == '{' || c == '[') {
+                    if (e->profundidade < PROFUNDIDADE_JSON) {
+                        NivelJson *novo = &e->pilha[e->profundidade];
+                        novo->tipo = c;
+                        novo->indice = 0;
+                        novo->esperando_chave = (c == '{');
+                        novo->chave[0] = '\0';
+                    }
+                    e->profundidade++;
+                } else if (c == '}' || c == ']') {
+                    if (e->profundidade > 0) e->profundidade--;
+                } else if (c == ',' && topo) {
+                    if (topo->tipo == '[') topo->indice++;
+                    else topo->esperando_chave = 1;
+                } else if (c == ':' && topo) {
+                    topo->esperando_chave = 0;
+                } else if (c == '"') {
+                    e->estado = EXTRATOR_STRING;
+                    e->eh_chave = topo && topo->tipo == '{' && topo->esperando_chave;
+                    e->capturando = !e->eh_chave && !e->encontrado && caminhoDoTexto(e);
+                    if (e->eh_chave) {
+                        e->tam_chave = 0;
+                        topo->chave[0] = '\0';
+                    }
+                }
+                topo = (e->profundidade > 0 && e->profundidade <= PROFUNDIDADE_JSON) ? &e->pilha[e->profundidade - 1] : NULL;
+                break;
+            case EXTRATOR_STRING: {
+                // Copia de uma vez o trecho sem aspas nem escapes
+                size_t j = i;
+                while (j < tamanho && dados[j] != '"' && dados[j] != '\\') j++;
+                if (j > i) {
+                    if (e->capturando) anexarTexto(&e->texto, dados + i, j - i);
+                    else for (size_t k = i; k < j; k++) caractereExtraido(e, dados[k]);
+                }
+                i = j;
+                if (i == tamanho) break;
+                if (dados[i] == '\\') {
+                    e->estado = EXTRATOR_ESCAPE;
+                } else {
+                    e->estado = EXTRATOR_FORA;
+                    if (e->capturando) e->encontrado = 1;
+                    e->capturando = 0;
+                }
+                break;
+            }
+            case EXTRATOR_ESCAPE:
+                e->estado = EXTRATOR_STRING;
+                switch (c) {
+                    case 'n': caractereExtraido(e, '\n'); break;
+                    case 't': caractereExtraido(e, '\t'); break;
+                    case 'r': caractereExtraido(e, '\r'); break;
+                    case 'b': caractereExtraido(e, '\b'); break;
+                    case 'f': caractereExtraido(e, '\f'); break;
+                    case 'u': e->estado = EXTRATOR_UNICODE; e->codigo = 0; e->digitos = 0; break;
+                    default:  caractereExtraido(e, c); break;  // \" \\ \/
+                }
+                break;
+            case EXTRATOR_UNICODE: {
+                int v = isdigit((unsigned char)c) ? c - '0' : (tolower((unsigned char)c) >= 'a' && tolower((unsigned char)c) <= 'f') ? tolower((unsigned char)c) - 'a' + 10 : 0;
+                e->codigo = (e->codigo << 4) | (unsigned)v;
+                if (++e->digitos < 4) break;
+                e->estado = EXTRATOR_STRING;
+                if (!e->capturando) break;
+                if (e->codigo >= 0xD800 && e->codigo <= 0xDBFF) {
+                    e->surrogate = e->codigo;
+                } else if (e->codigo >= 0xDC00 && e->codigo <= 0xDFFF && e->surrogate) {
+                    anexarUtf8(&e->texto, 0x10000 + ((e->surrogate - 0xD800) << 10) + (e->codigo - 0xDC00));
+                    e->surrogate = 0;
+                } else {
+                    anexarUtf8(&e->texto, e->codigo);
+                }
+                break;
+            }
+        }
+    }
+}
+
+void iniciarResposta(RespostaGemini *resposta, CURL *curl) {
+    TextoDinamico bruto = resposta->bruto;
+    TextoDinamico texto = resposta->extrator.texto;
+    memset(resposta, 0, sizeof(*resposta));
+    // Os buffers de uma resposta anterior são reaproveitados
+    resposta->curl = curl;
+    resposta->bruto = bruto;
+    resposta->bruto.tamanho = 0;
+    resposta->extrator.texto = texto;
+    resposta->extrator.texto.tamanho = 0;
+    if (bruto.dados) bruto.dados[0] = '\0';
+    if (texto.dados) texto.dados[0] = '\0';
+}
+
+void liberarResposta(RespostaGemini *resposta) {
+    liberarTexto(&resposta->bruto);
+    liberarTexto(&resposta->extrator.texto);
+}
+
+static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    RespostaGemini *resposta = (RespostaGemini *)userp;
+    if (!resposta->preparada) {
+        // Reserva de uma vez o tamanho anunciado; sem ele, o buffer cresce em dobro
+        curl_off_t anunciado = -1;
+        curl_easy_getinfo(resposta->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &anunciado);
+        if (anunciado > 0 && anunciado < (curl_off_t)64 * 1024 * 1024) reservarTexto(&resposta->bruto, (size_t)anunciado);
+        resposta->preparada = 1;
+    }
+    if (!anexarTexto(&resposta->bruto, contents, realsize)) return 0;
+    double inicio = cronometroMs();
+    alimentarExtrator(&resposta->extrator, contents, realsize);
+    resposta->tempo_interpretacao_ms += cronometroMs() - inicio;
+    return realsize;
+}
+
+// Opções fixas: configuradas uma única vez por handle e mantidas entre chamadas
+void configurarHandleGemini(ClienteGemini *cliente, CURL *curl) {
+    curl_easy_setopt(curl, CURLOPT_SHARE, cliente->share);
+    curl_easy_setopt(curl, CURLOPT_URL, cliente->url);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, cliente->headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 60L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 30L);
+}
+
+int inicializarClienteGemini(ClienteGemini *cliente, const char *url) {
+    memset(cliente, 0, sizeof(*cliente));
+    // GEMINI_URL no ambiente permite apontar para um servidor local de testes
+    const char *url_ambiente = getenv("GEMINI_URL");
+    cliente->url = strdup(url_ambiente && url_ambiente[0] ? url_ambiente : url);
+    cliente->share = curl_share_init();
+    if (!cliente->url || !cliente->share) {
+        fprintf(stderr, "Erro: falha ao inicializar cURL\n");
+        return 0;
+    }
+    curl_share_setopt(cliente->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(cliente->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(cliente->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+
+    cliente->headers = curl_slist_append(NULL, "Content-Type: application/json");
+
+    // ...:generateContent?key=X -> ...:streamGenerateContent?key=X&alt=sse
+    const char *metodo = strstr(cliente->url, ":generateContent");
+    if (metodo) {
+        const char *resto = metodo + strlen(":generateContent");
+        size_t tam = strlen(cliente->url) + 32;
+        cliente->url_stream = malloc(tam);
+        if (cliente->url_stream) {
+            snprintf(cliente->url_stream, tam, "%.*s:streamGenerateContent%s%salt=sse",
+                     (int)(metodo - cliente->url), cliente->url, resto, strchr(resto, '?') ? "&" : "?");
+        }
+    }
+    return 1;
+}
+
+void encerrarClienteGemini(ClienteGemini *cliente) {
+    if (cliente->share) curl_share_cleanup(cliente->share);
+    curl_slist_free_all(cliente->headers);
+    free(cliente->url);
+    free(cliente->url_stream);
+    memset(cliente, 0, sizeof(*cliente));
+}
+
+// Corpo da requisição escrito diretamente, sem montar uma árvore cJSON. Com
+// 'esquema' (um responseSchema), pede a resposta em JSON nesse formato.
+char* montarCorpoComEsquema(const char *prompt, const char *esquema) {
+    static const char inicio[] = "{\"contents\":[{\"role\":\"user\",\"parts\":[{\"text\":";
+    static const char fim[] = "}]}]";
+    static const char configuracao[] = ",\"generationConfig\":{\"responseMimeType\":\"application/json\",\"responseSchema\":";
+    TextoDinamico corpo = {0};
+    int ok = reservarTexto(&corpo, sizeof(inicio) + strlen(prompt) + sizeof(fim) + sizeof(configuracao) + (esquema ? strlen(esquema) : 0) + 64) &&
+             anexarTexto(&corpo, inicio, sizeof(inicio) - 1) &&
+             anexarStringJson(&corpo, prompt) &&
+             anexarTexto(&corpo, fim, sizeof(fim) - 1);
+    if (ok && esquema) ok = anexarTexto(&corpo, configuracao, sizeof(configuracao) - 1) && anexarString(&corpo, esquema) && anexarString(&corpo, "}");
+    if (!ok || !anexarString(&corpo, "}")) {
+        liberarTexto(&corpo);
+        return NULL;
+    }
+    return extrairTexto(&corpo);
+}
+
+char* montarCorpoRequisicao(const char *prompt) {
+    return montarCorpoComEsquema(prompt, NULL);
+}
+
+// Extrai o texto de uma resposta concluída; registra erros em stderr e retorna NULL
+char* interpretarResposta(CURLcode res, long http_code, RespostaGemini *resposta) {
+    TextoDinamico *chunk = &resposta->bruto;
+    if (res != CURLE_OK) {
+        fprintf(stderr, "cURL error: %s\n", curl_easy_strerror(res));
+        if (chunk->tamanho > 0 && chunk->dados) {
+            fprintf(stderr, "Resposta bruta (quando cURL falhou):\n%s\n", chunk->dados);
+        }
+        return NULL;
+    }
+    if (http_code >= 400) {
+        fprintf(stderr, "HTTP error: %ld\n", http_code);
+        if (chunk->tamanho > 0 && chunk->dados) {
+            fprintf(stderr, "Resposta bruta:\n%s\n", chunk->dados);
+
+            cJSON *resp = cJSON_Parse(chunk->dados);
+            if (resp) {
+                cJSON *error = cJSON_GetObjectItem(resp, "error");
+                if (error) {
+                    cJSON *msg = cJSON_GetObjectItem(error, "message");
+                    cJSON *code = cJSON_GetObjectItem(error, "code");
+                    cJSON *status = cJSON_GetObjectItem(error, "status");
+                    if (msg) fprintf(stderr, "API error.message: %s\n", cJSON_GetStringValue(msg));
+                    if (code) {
+                        if (cJSON_IsNumber(code)) fprintf(stderr, "API error.code: %d\n", code->valueint);
+                        else fprintf(stderr, "API error.code: %s\n", cJSON_GetStringValue(code));
+                    }
+                    if (status) fprintf(stderr, "API error.status: %s\n", cJSON_GetStringValue(status));
+                } else {
+                    cJSON *errMsg = cJSON_GetObjectItem(resp, "errorMessage");
+                    if (errMsg) fprintf(stderr, "API errorMessage: %s\n", cJSON_GetStringValue(errMsg));
+                }
+                cJSON_Delete(resp);
+            } else {
+                fprintf(stderr, "Resposta não é JSON válido.\n");
+            }
+        } else {
+            fprintf(stderr, "Nenhuma resposta do servidor.\n");
+        }
+
+        return NULL;
+    }
+
+    if (resposta->extrator.encontrado) return extrairTexto(&resposta->extrator.texto);
+
+    cJSON *response = chunk->dados ? cJSON_Parse(chunk->dados) : NULL;
+    if (response) {
+        fprintf(stderr, "Resposta JSON recebida, mas campo esperado não encontrado. Resposta bruta:\n%s\n", chunk->dados);
+        cJSON_Delete(response);
+    } else {
+        fprintf(stderr, "Erro ao parsear JSON de resposta.\n");
+        if (chunk->tamanho > 0) fprintf(stderr, "Resposta bruta:\n%s\n", chunk->dados);
+    }
+
+    return NULL;
+}
+
+// STREAMING DE RESPOSTAS (SSE)
+
+void fecharLinhaStream(RespostaStream *fluxo) {
+    for (int j = fluxo->coluna; j < WIDTH - 2; j++) putchar(' ');
+    printf("║\n");
+    fluxo->linha_aberta = 0;
+    fluxo->coluna = 0;
+}
+
+// Desenha o texto dentro da caixa (mesmo formato de mostrarTextoMultiline),
+// quebrando as linhas em WIDTH - 2 caracteres
+void escreverNaCaixa(RespostaStream *fluxo, const char *texto, size_t tamanho) {
+    if (!fluxo->caixa_aberta) {
+        if (fluxo->progresso_na_tela) printf("\r\033[K");
+        fluxo->progresso_na_tela = 0;
+        print_border_top();
+        fluxo->caixa_aberta = 1;
+    }
+    for (size_t i = 0; i < tamanho; i++) {
+        unsigned char c = (unsigned char)texto[i];
+        if (c == '\r') continue;
+        if (!fluxo->linha_aberta) {
+            printf("║");
+            fluxo->linha_aberta = 1;
+        }
+        if (c == '\n') {
+            fecharLinhaStream(fluxo);
+            continue;
+        }
+        // Bytes de continuação UTF-8 não ocupam coluna
+        if ((c & 0xC0) != 0x80) {
+            if (fluxo->coluna == WIDTH - 2) {
+                fecharLinhaStream(fluxo);
+                printf("║");
+                fluxo->linha_aberta = 1;
+            }
+            fluxo->coluna++;
+        }
+        putchar(c == '\t' ? ' ' : c);
+    }
+}
+
+void fecharCaixaStream(RespostaStream *fluxo) {
+    if (fluxo->linha_aberta) fecharLinhaStream(fluxo);
+    if (fluxo->caixa_aberta) print_border_bottom();
+    fluxo->caixa_aberta = 0;
+}
+
+// Trata uma linha "data: {...}" do stream: cada evento traz um pedaço do texto
+void processarEventoSSE(RespostaStream *fluxo, const char *linha) {
+    if (strncmp(linha, "data:", 5) != 0) return;  // comentários, "event:", "id:"...
+    linha += 5;
+    while (*linha == ' ') linha++;
+
+    double inicio = cronometroMs();
+    cJSON *evento = cJSON_Parse(linha);
+    fluxo->tempo_interpretacao_ms += cronometroMs() - inicio;
+    if (!evento) {
+        fprintf(stderr, "Evento SSE inválido: %s\n", linha);
+        return;
+    }
+    cJSON *error = cJSON_GetObjectItem(evento, "error");
+    if (error) {
+        cJSON *msg = cJSON_GetObjectItem(error, "message");
+        fprintf(stderr, "API error.message: %s\n", msg ? cJSON_GetStringValue(msg) : "(sem mensagem)");
+    }
+    cJSON *candidates = cJSON_GetObjectItem(evento, "candidates");
+    cJSON *candidate = candidates ? cJSON_GetArrayItem(candidates, 0) : NULL;
+    cJSON *content = candidate ? cJSON_GetObjectItem(candidate, "content") : NULL;
+    cJSON *parts = content ? cJSON_GetObjectItem(content, "parts") : NULL;
+    int total = parts ? cJSON_GetArraySize(parts) : 0;
+    for (int i = 0; i < total; i++) {
+        const char *texto = cJSON_GetStringValue(cJSON_GetObjectItem(cJSON_GetArrayItem(parts, i), "text"));
+        if (!texto || !texto[0]) continue;
+        size_t tam = strlen(texto);
+        anexarTexto(&fluxo->texto, texto, tam);
+        if (fluxo->desenhar) escreverNaCaixa(fluxo, texto, tam);
+    }
+    cJSON_Delete(evento);
+}
+
+// Consome as linhas completas acumuladas; o resto fica para o próximo pedaço
+void consumirLinhasSSE(RespostaStream *fluxo) {
+    char *inicio = fluxo->pendente.dados;
+    char *fim;
+    while ((fim = memchr(inicio, '\n', fluxo->pendente.tamanho - (size_t)(inicio - fluxo->pendente.dados))) != NULL) {
+        *fim = '\0';
+        if (fim > inicio && fim[-1] == '\r') fim[-1] = '\0';
+        if (*inicio) processarEventoSSE(fluxo, inicio);
+        inicio = fim + 1;
+    }
+    size_t restante = fluxo->pendente.tamanho - (size_t)(inicio - fluxo->pendente.dados);
+    memmove(fluxo->pendente.dados, inicio, restante);
+    fluxo->pendente.tamanho = restante;
+    fluxo->pendente.dados[restante] = '\0';
+}
+
+static size_t StreamCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    RespostaStream *fluxo = (RespostaStream *)userp;
+
+    if (fluxo->modo == 0) {
+        // Respostas de erro chegam como JSON comum: guardadas inteiras para interpretarResposta
+        long http_code = 0;
+        char *tipo = NULL;
+        curl_easy_getinfo(fluxo->curl, CURLINFO_RESPONSE_CODE, &http_code);
+        curl_easy_getinfo(fluxo->curl, CURLINFO_CONTENT_TYPE, &tipo);
+        fluxo->modo = (http_code < 400 && tipo && strstr(tipo, "text/event-stream")) ? 1 : 2;
+    }
+    if (!anexarTexto(&fluxo->pendente, contents, realsize)) return 0;
+    if (fluxo->modo == 1) {
+        consumirLinhasSSE(fluxo);
+        if (fluxo->desenhar) fflush(stdout);
+    }
+    return realsize;
+}
+
+// Configura 'curl' para enviar 'corpo' ao endpoint streamGenerateContent
+// (ou ao comum, se a URL não permitir streaming), acumulando em 'fluxo'
+void prepararStream(ClienteGemini *cliente, CURL *curl, RespostaStream *fluxo, const char *corpo) {
+    memset(fluxo, 0, sizeof(*fluxo));
+    fluxo->curl = curl;
+    curl_easy_setopt(curl, CURLOPT_URL, cliente->url_stream ? cliente->url_stream : cliente->url);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, StreamCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)fluxo);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, corpo);
+}
+
+// Texto final de uma transferência em streaming terminada (NULL em caso de erro).
+// O texto parcial continua em fluxo->texto até liberarStream.
+char* concluirStream(RespostaStream *fluxo, CURLcode res, long http_code) {
+    char *resultado = NULL;
+    if (fluxo->modo == 1) {
+        if (fluxo->pendente.tamanho > 0) processarEventoSSE(fluxo, fluxo->pendente.dados);  // último evento sem '\n'
+        fluxo->pendente.tamanho = 0;
+        if (res != CURLE_OK) fprintf(stderr, "cURL error: %s\n", curl_easy_strerror(res));
+        else if (fluxo->texto.tamanho > 0) resultado = strdup(fluxo->texto.dados);
+    } else {
+        // Corpo comum (erro ou JSON sem SSE): mesmo tratamento da chamada normal
+        RespostaGemini resposta = {0};
+        iniciarResposta(&resposta, fluxo->curl);
+        resposta.bruto = fluxo->pendente;
+        memset(&fluxo->pendente, 0, sizeof(fluxo->pendente));
+        alimentarExtrator(&resposta.extrator, resposta.bruto.dados ? resposta.bruto.dados : "", resposta.bruto.tamanho);
+        resultado = interpretarResposta(res, http_code, &resposta);
+        liberarResposta(&resposta);
+    }
+    return resultado;
+}
+
+void liberarStream(RespostaStream *fluxo) {
+    liberarTexto(&fluxo->pendente);
+    liberarTexto(&fluxo->texto);
+}
+
+void adicionarTrecho(ModeloPrompt *modelo, TipoTrecho tipo, const char *texto, size_t tamanho) {
+    if (tipo == TRECHO_LITERAL && tamanho == 0) return;
+    TrechoPrompt *novo = realloc(modelo->trechos, (modelo->total + 1) * sizeof(TrechoPrompt));
+    if (!novo) return;
+    modelo->trechos = novo;
+    modelo->trechos[modelo->total++] = (TrechoPrompt){tipo, texto, tamanho};
+    if (tipo == TRECHO_LITERAL) modelo->tamanho_literais += tamanho;
+}
+
+// Separa o texto de prompt.txt em literais e marcadores. Se o arquivo não
+// tiver marcadores, os dados do mentorado e a lista de mentores são
+// acrescentados ao final no formato padrão.
+void compilarModeloPrompt(ModeloPrompt *modelo, const char *caminho) {
+    static const char *marcadores[] = {"{mentorado}", "{objetivo}", "{mentores}"};
+    static const TipoTrecho tipos[] = {TRECHO_MENTORADO, TRECHO_OBJETIVO, TRECHO_MENTORES};
+    static const char sufixo[] = "\n\nMentorado: {mentorado}\nObjetivo: {objetivo}\n\nMentores disponiveis:\n{mentores}"
+        "\nCom base nisso, indique 1-3 mentores ideais (por numero e nome), explique o porquê da escolha, quais passos iniciais o mentorado deve seguir e sugira uma primeira atividade/prioridade.\n";
+    memset(modelo, 0, sizeof(*modelo));
+
+    TextoDinamico fonte = {0};
+    FILE *f = fopen(caminho, "r");
+    if (f) {
+        char buf[4096];
+        size_t lidos;
+        while ((lidos = fread(buf, 1, sizeof(buf), f)) > 0) anexarTexto(&fonte, buf, lidos);
+        fclose(f);
+    } else {
+        anexarString(&fonte, "Você é um mentor virtual que ajuda a combinar mentorados com mentores com base em experiência, área e objetivo profissional. Dê recomendações claras e razões.");
+    }
+    if (!strstr(fonte.dados ? fonte.dados : "", "{mentores}")) anexarString(&fonte, sufixo);
+    modelo->fonte = extrairTexto(&fonte);
+
+    const char *p = modelo->fonte;
+    const char *literal = p;
+    while ((p = strchr(p, '{')) != NULL) {
+        int achou = 0;
+        for (int m = 0; m < 3 && !achou; m++) {
+            size_t tam = strlen(marcadores[m]);
+            if (strncmp(p, marcadores[m], tam) != 0) continue;
+            adicionarTrecho(modelo, TRECHO_LITERAL, literal, (size_t)(p - literal));
+            adicionarTrecho(modelo, tipos[m], NULL, 0);
+            p += tam;
+            literal = p;
+            achou = 1;
+        }
+        if (!achou) p++;
+    }
+    adicionarTrecho(modelo, TRECHO_LITERAL, literal, strlen(literal));
+}
+
+void liberarModeloPrompt(ModeloPrompt *modelo) {
+    free(modelo->fonte);
+    free(modelo->trechos);
+    memset(modelo, 0, sizeof(*modelo));
+}
+
+// Monta o prompt de um mentorado com a lista de mentores 'candidatos'
+char* montarPromptComCandidatos(const ModeloPrompt *modelo, const Mentor *mentores, const Mentorado *mentorado,
+                                const CandidatoMentor *candidatos, int totalCandidatos) {
+    TextoDinamico prompt = {0};
+    if (!reservarTexto(&prompt, modelo->tamanho_literais + 512 + (size_t)totalCandidatos * 256)) return NULL;
+    int ok = 1;
+    for (int i = 0; i < modelo->total && ok; i++) {
+        const TrechoPrompt *trecho = &modelo->trechos[i];
+        switch (trecho->tipo) {
+            case TRECHO_LITERAL:   ok = anexarTexto(&prompt, trecho->texto, trecho->tamanho); break;
+            case TRECHO_MENTORADO: ok = anexarString(&prompt, mentorado->nome); break;
+            case TRECHO_OBJETIVO:  ok = anexarString(&prompt, mentorado->objetivo); break;
+            case TRECHO_MENTORES:
+                for (int c = 0; c < totalCandidatos && ok; c++) {
+                    const Mentor *m = &mentores[candidatos[c].indice];
+                    ok = anexarFormatado(&prompt, "%d) %s — Area: %s, XP: %d anos\n", candidatos[c].indice + 1, m->nome, m->area, m->experiencia);
+                }
+                break;
+        }
+    }
+    if (!ok) {
+        liberarTexto(&prompt);
+        return NULL;
+    }
+    return extrairTexto(&prompt);
+}
+
+// Monta o prompt de um mentorado com os candidatos do pré-ranqueamento local.
+// 'candidatos' recebe até TOP_K_MENTORES entradas (usadas no fallback offline).
+char* montarPromptMentoria(const ModeloPrompt *modelo, const Mentor *mentores, int totalMentores, const Mentorado *mentorado,
+                           CandidatoMentor *candidatos, int *totalCandidatos) {
+    *totalCandidatos = preRanquearMentores(mentores, totalMentores, mentorado, candidatos, TOP_K_MENTORES);
+    return montarPromptComCandidatos(modelo, mentores, mentorado, candidatos, *totalCandidatos);
+}
+
+// CACHE DE RESPOSTAS
+
+uint64_t misturarHash(uint64_t h, uint64_t valor) {
+    h ^= valor;
+    return h * 1099511628211ULL;
+}
+
+// Mistura ao hash os trechos do modelo compilado: o que vale é o modelo em
+// uso, não o prompt.txt atual (ele só é lido na inicialização)
+uint64_t misturarModeloPrompt(uint64_t h, const ModeloPrompt *modelo) {
+    for (int i = 0; i < modelo->total; i++) {
+        const TrechoPrompt *trecho = &modelo->trechos[i];
+        h = misturarHash(h, (uint64_t)trecho->tipo + 1);
+        for (size_t j = 0; j < trecho->tamanho; j++) h = misturarHash(h, (unsigned char)trecho->texto[j]);
+    }
+    return h;
+}
+
+void indexarCache(CacheRespostas *cache, uint64_t hash, long offset, uint32_t tamanho) {
+    if ((cache->total + 1) * 2 > cache->capacidade) {
+        int nova_capacidade = cache->capacidade ? cache->capacidade * 2 : 64;
+        EntradaCache *novas = calloc(nova_capacidade, sizeof(EntradaCache));
+        if (!novas) return;
+        for (int i = 0; i < cache->capacidade; i++) {
+            if (!cache->entradas[i].hash) continue;
+            int j = (int)(cache->entradas[i].hash & (uint64_t)(nova_capacidade - 1));
+            while (novas[j].hash) j = (j + 1) & (nova_capacidade - 1);
+            novas[j] = cache->entradas[i];
+        }
+        free(cache->entradas);
+        cache->entradas = novas;
+        cache->capacidade = nova_capacidade;
+    }
+    int i = (int)(hash & (uint64_t)(cache->capacidade - 1));
+    while (cache->entradas[i].hash && cache->entradas[i].hash != hash) i = (i + 1) & (cache->capacidade - 1);
+    if (!cache->entradas[i].hash) cache->total++;
+    cache->entradas[i].hash = hash;
+    cache->entradas[i].offset = offset;
+    cache->entradas[i].tamanho = tamanho;
+}
+
+void descartarIndiceCache(CacheRespostas *cache) {
+    free(cache->entradas);
+    cache->entradas = NULL;
+    cache->capacidade = cache->total = 0;
+}
+
+// Esvazia o arquivo e grava o cabeçalho com uma geração nova: as outras
+// sessões veem a troca no próximo acesso e descartam o índice delas.
+// Chamada com a trava.
+void limparCache(CacheRespostas *cache) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t geracao = misturarHash(misturarHash(misturarHash(cache->geracao, (uint64_t)ts.tv_sec), (uint64_t)ts.tv_nsec),
+                                    (uint64_t)getpid());
+    int64_t seq = persistencia_mentores.seq;
+    descartarIndiceCache(cache);
+    cache->geracao = geracao;
+    cache->fim = TAM_CABECALHO_CACHE;
+    if (ftruncate(fileno(cache->arquivo), 0) != 0 ||
+        fwrite(CACHE_ASSINATURA, 1, 4, cache->arquivo) != 4 ||
+        fwrite(&cache->modelo, sizeof(cache->modelo), 1, cache->arquivo) != 1 ||
+        fwrite(&seq, sizeof(seq), 1, cache->arquivo) != 1 ||
+        fwrite(&geracao, sizeof(geracao), 1, cache->arquivo) != 1) {
+        cache->fim = 0;  // cabeçalho incompleto: a próxima sincronização limpa de novo
+    }
+    fflush(cache->arquivo);
+}
+
+// Indexa os registros anexados depois de 'fim' (inclusive os de outras
+// sessões). Registro incompleto no fim (ex.: queda durante a escrita) é
+// descartado; com a trava, nenhuma sessão está no meio de uma escrita.
+int indexarNovosRegistros(CacheRespostas *cache) {
+    struct stat st;
+    if (fstat(fileno(cache->arquivo), &st) != 0) return 0;
+    unsigned char registro[sizeof(uint64_t) + sizeof(uint32_t)];
+    while (cache->fim + (long)sizeof(registro) <= (long)st.st_size &&
+           pread(fileno(cache->arquivo), registro, sizeof(registro), cache->fim) == (ssize_t)sizeof(registro)) {
+        uint64_t hash;
+        uint32_t tamanho;
+        memcpy(&hash, registro, sizeof(hash));
+        memcpy(&tamanho, registro + sizeof(hash), sizeof(tamanho));
+        long offset = cache->fim + (long)sizeof(registro);
+        if (offset + (long)tamanho > (long)st.st_size) break;
+        indexarCache(cache, hash, offset, tamanho);
+        cache->fim = offset + tamanho;
+    }
+    return st.st_size == cache->fim || ftruncate(fileno(cache->arquivo), cache->fim) == 0;
+}
+
+// Põe o índice em dia com o arquivo. Chamada com a trava; retorna 0 se o
+// cache não pode ser usado agora. Um cabeçalho de outro modelo ou de uma
+// sequência de mentores anterior à desta sessão é descartado; um de
+// sequência posterior é de uma sessão com mentores que esta ainda não leu,
+// e o cache fica de lado até a próxima sincronização dos mentores.
+int sincronizarCache(CacheRespostas *cache) {
+    if (!cache->arquivo) return 0;
+    unsigned char cabecalho[TAM_CABECALHO_CACHE];
+    uint64_t modelo, geracao;
+    int64_t seq;
+    if (pread(fileno(cache->arquivo), cabecalho, sizeof(cabecalho), 0) != (ssize_t)sizeof(cabecalho) ||
+        memcmp(cabecalho, CACHE_ASSINATURA, 4) != 0) {
+        limparCache(cache);
+        return cache->fim > 0;
+    }
+    memcpy(&modelo, cabecalho + 4, sizeof(modelo));
+    memcpy(&seq, cabecalho + 12, sizeof(seq));
+    memcpy(&geracao, cabecalho + 20, sizeof(geracao));
+    if (seq > persistencia_mentores.seq) return 0;
+    if (seq < persistencia_mentores.seq || modelo != cache->modelo) {
+        limparCache(cache);
+        return cache->fim > 0;
+    }
+    if (geracao != cache->geracao) {
+        // Outra sessão limpou o cache: as posições do índice não valem mais
+        descartarIndiceCache(cache);
+        cache->geracao = geracao;
+        cache->fim = TAM_CABECALHO_CACHE;
+    }
+    return indexarNovosRegistros(cache);
+}
+
+// Abre o arquivo sem lê-lo: o índice é montado no primeiro acesso, quando
+// os mentores já foram carregados
+void abrirCache(CacheRespostas *cache, const ModeloPrompt *modelo) {
+    memset(cache, 0, sizeof(*cache));
+    cache->trava = -1;
+    cache->modelo = misturarModeloPrompt(1469598103934665603ULL, modelo);
+    cache->arquivo = fopen(ARQ_CACHE, "a+b");
+}
+
+void fecharCache(CacheRespostas *cache) {
+    if (cache->arquivo) fclose(cache->arquivo);
+    if (cache->trava >= 0) close(cache->trava);
+    free(cache->entradas);
+    memset(cache, 0, sizeof(*cache));
+    cache->trava = -1;
+}
+
+char* buscarNoCache(CacheRespostas *cache, const char *prompt) {
+    travarArquivo(&cache->trava, ARQ_TRAVA_CACHE);
+    char *texto = NULL;
+    if (sincronizarCache(cache) && cache->total > 0) {
+        uint64_t hash = hashTexto(prompt);
+        int i = (int)(hash & (uint64_t)(cache->capacidade - 1));
+        while (cache->entradas[i].hash && cache->entradas[i].hash != hash) i = (i + 1) & (cache->capacidade - 1);
+        if (cache->entradas[i].hash) texto = malloc(cache->entradas[i].tamanho + 1);
+        if (texto && pread(fileno(cache->arquivo), texto, cache->entradas[i].tamanho, cache->entradas[i].offset) !=
+                         (ssize_t)cache->entradas[i].tamanho) {
+            free(texto);
+            texto = NULL;
+        }
+        if (texto) texto[cache->entradas[i].tamanho] = '\0';
+    }
+    destravarArquivo(cache->trava);
+    return texto;
+}
+
+void gravarNoCache(CacheRespostas *cache, const char *prompt, const char *resposta) {
+    travarArquivo(&cache->trava, ARQ_TRAVA_CACHE);
+    if (sincronizarCache(cache)) {
+        uint64_t hash = hashTexto(prompt);
+        uint32_t tamanho = (uint32_t)strlen(resposta);
+        long offset = cache->fim + (long)(sizeof(hash) + sizeof(tamanho));
+        // O arquivo é aberto para anexar, e com a trava o fim é 'fim'
+        if (fwrite(&hash, sizeof(hash), 1, cache->arquivo) == 1 && fwrite(&tamanho, sizeof(tamanho), 1, cache->arquivo) == 1 &&
+            fwrite(resposta, 1, tamanho, cache->arquivo) == tamanho && fflush(cache->arquivo) == 0) {
+            indexarCache(cache, hash, offset, tamanho);
+            cache->fim = offset + tamanho;
+        } else {
+            fflush(cache->arquivo);  // o registro incompleto é descartado na próxima sincronização
+        }
+    }
+    destravarArquivo(cache->trava);
+}
+
+// HISTÓRICO DE RESULTADOS
+
+HistoricoResultados historico_resultados = {.trava = -1};
+
+// Versão das entradas comuns a todos os mentorados: mentores ativos (na
+// ordem) e o modelo de prompt compilado. Custa uma passada pelos mentores
+// por operação, não por mentorado. Compactações não a alteram, porque a
+// ordem relativa dos mentores ativos se mantém.
+uint64_t versaoDasEntradas(const Mentor *mentores, int total, const ModeloPrompt *modelo) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < total; i++) {
+        if (!registroAtivo(&persistencia_mentores, i)) continue;
+        h = misturarHash(misturarHash(misturarHash(h, hashTexto(mentores[i].nome)), hashTexto(mentores[i].area)),
+                         (uint64_t)mentores[i].experiencia);
+    }
+    return misturarModeloPrompt(h, modelo);
+}
+
+// Hash das entradas de um mentorado: igual ao de um resultado gravado, a
+// recomendação partiria dos mesmos dados e não precisa ser refeita
+uint64_t entradaDoMentorado(const Mentorado *mentorado, uint64_t versao) {
+    uint64_t h = misturarHash(misturarHash(versao, hashTexto(mentorado->nome)), hashTexto(mentorado->objetivo));
+    return h ? h : 1;
+}
+
+// Posição do mentorado no índice: a dele, ou a vazia onde entraria
+int posicaoHistorico(const HistoricoResultados *h, const char *mentorado, uint64_t chave) {
+    int i = (int)(chave & (uint64_t)(h->capacidade_indice - 1));
+    while (h->indice[i].chave &&
+           (h->indice[i].chave != chave || strcmp(h->itens[h->indice[i].ultimo].mentorado, mentorado) != 0)) {
+        i = (i + 1) & (h->capacidade_indice - 1);
+    }
+    return i;
+}
+
+// Liga o resultado 'id' ao mentorado: ele passa a ser o mais recente e
+// aponta para o anterior
+void indexarResultado(HistoricoResultados *h, int id) {
+    ResultadoMentoria *r = &h->itens[id];
+    r->anterior = -1;
+    if ((h->mentorados + 1) * 2 > h->capacidade_indice) {
+        int nova_capacidade = h->capacidade_indice ? h->capacidade_indice * 2 : 64;
+        EntradaHistorico *novas = calloc(nova_capacidade, sizeof(EntradaHistorico));
+        if (!novas) return;
+        for (int i = 0; i < h->capacidade_indice; i++) {
+            if (!h->indice[i].chave) continue;
+            int j = (int)(h->indice[i].chave & (uint64_t)(nova_capacidade - 1));
+            while (novas[j].chave) j = (j + 1) & (nova_capacidade - 1);
+            novas[j] = h->indice[i];
+        }
+        free(h->indice);
+        h->indice = novas;
+        h->capacidade_indice = nova_capacidade;
+    }
+    uint64_t chave = hashTexto(r->mentorado);
+    int i = posicaoHistorico(h, r->mentorado, chave);
+    if (h->indice[i].chave) {
+        r->anterior = h->indice[i].ultimo;
+    } else {
+        h->indice[i].chave = chave;
+        h->mentorados++;
+    }
+    h->indice[i].ultimo = id;
+}
+
+// Resultado mais recente do mentorado, ou -1
+int ultimoResultado(const HistoricoResultados *h, const char *mentorado) {
+    if (h->mentorados == 0) return -1;
+    int i = posicaoHistorico(h, mentorado, hashTexto(mentorado));
+    return h->indice[i].chave ? h->indice[i].ultimo : -1;
+}
+
+// Só resultados com mentores identificados e vindos do modelo (ou da
+// atribuição) dispensam uma nova consulta: o fallback local não
+int resultadoReaproveitavel(const ResultadoMentoria *r) {
+    return r->total > 0 && strcmp(r->origem, "local") != 0;
+}
+
+// Resultado mais recente do mentorado que ainda vale para 'entrada', ou
+// NULL. Com 'fixo' (mentor escolhido pela atribuição global) só vale a
+// justificativa desse mesmo par; sem ele, só as recomendações livres.
+const ResultadoMentoria* resultadoAtual(const HistoricoResultados *h, const char *mentorado, uint64_t entrada, const char *fixo) {
+    for (int id = ultimoResultado(h, mentorado); id >= 0; id = h->itens[id].anterior) {
+        const ResultadoMentoria *r = &h->itens[id];
+        if (r->entrada != entrada || !resultadoReaproveitavel(r)) continue;
+        int par = strcmp(r->origem, "atribuicao") == 0;
+        if (fixo ? par && strcmp(r->mentores[0], fixo) == 0 : !par) return r;
+    }
+    return NULL;
+}
+
+// Linha: momento;entrada;origem;mentorado[;mentor;pontuação]...
+int interpretarLinhaResultado(char *linha, ResultadoMentoria *r) {
+    char *campos[4 + 2 * MAX_RECOMENDADOS];
+    int n = 0;
+    char *p = linha;
+    linha[strcspn(linha, "\n")] = '\0';
+    while (p && n < (int)(sizeof(campos) / sizeof(campos[0]))) {
+        campos[n++] = p;
+        p = strchr(p, ';');
+        if (p) *p++ = '\0';
+    }
+    if (n < 4 || n % 2 != 0 || !campos[3][0]) return 0;
+    memset(r, 0, sizeof(*r));
+    r->momento = atol(campos[0]);
+    r->entrada = strtoull(campos[1], NULL, 16);
+    snprintf(r->origem, sizeof(r->origem), "%s", campos[2]);
+    snprintf(r->mentorado, sizeof(r->mentorado), "%s", campos[3]);
+    for (int k = 4; k + 1 < n; k += 2) {
+        snprintf(r->mentores[r->total], sizeof(r->mentores[0]), "%s", campos[k]);
+        r->pontuacoes[r->total++] = strtod(campos[k + 1], NULL);
+    }
+    return 1;
+}
+
+// Com a trava, nenhuma outra sessão está no meio de uma gravação: uma
+// linha incompleta no fim só pode ser de uma escrita interrompida
+void abrirHistorico(HistoricoResultados *h) {
+    memset(h, 0, sizeof(*h));
+    h->trava = -1;
+    travarArquivo(&h->trava, ARQ_TRAVA_RESULTADOS);
+    FILE *f = fopen(ARQ_RESULTADOS, "r");
+    if (!f) {
+        destravarArquivo(h->trava);
+        return;
+    }
+    char linha[1024];
+    long valido = 0;  // fim da última linha completa
+    int parcial = 0;
+    while (fgets(linha, sizeof(linha), f)) {
+        if (!strchr(linha, '\n')) {
+            parcial = 1;
+            break;
+        }
+        valido = ftell(f);
+        ResultadoMentoria r;
+        if (!interpretarLinhaResultado(linha, &r)) continue;
+        if (!reservarLista((void **)&h->itens, h->total, &h->capacidade, sizeof(ResultadoMentoria))) break;
+        h->itens[h->total] = r;
+        indexarResultado(h, h->total++);
+    }
+    // Uma escrita interrompida deixa a última linha pela metade: ela é descartada
+    fclose(f);
+    if (parcial && truncate(ARQ_RESULTADOS, valido) != 0) printf("Erro ao reparar %s.\n", ARQ_RESULTADOS);
+    destravarArquivo(h->trava);
+}
+
+void fecharHistorico(HistoricoResultados *h) {
+    if (h->arquivo) fclose(h->arquivo);
+    if (h->trava >= 0) close(h->trava);
+    free(h->itens);
+    free(h->indice);
+    memset(h, 0, sizeof(*h));
+    h->trava = -1;
+}
+
+int resultadosIguais(const ResultadoMentoria *a, const ResultadoMentoria *b) {
+    if (a->entrada != b->entrada || a->total != b->total || strcmp(a->origem, b->origem) != 0) return 0;
+    for (int k = 0; k < a->total; k++) {
+        if (strcmp(a->mentores[k], b->mentores[k]) != 0) return 0;
+    }
+    return 1;
+}
+
+// Anexa o resultado ao arquivo e ao índice. Um resultado igual ao mais
+// recente do mentorado (mesmas entradas, origem e mentores) não é repetido.
+void registrarResultado(HistoricoResultados *h, ResultadoMentoria *r) {
+    int ultimo = ultimoResultado(h, r->mentorado);
+    if (ultimo >= 0 && resultadosIguais(&h->itens[ultimo], r)) return;
+    if (!reservarLista((void **)&h->itens, h->total, &h->capacidade, sizeof(ResultadoMentoria))) return;
+    r->momento = (long)time(NULL);
+    if (!h->arquivo) h->arquivo = fopen(ARQ_RESULTADOS, "a");
+    if (h->arquivo) {
+        // A linha vai inteira com a trava: outras sessões anexam ao mesmo arquivo
+        travarArquivo(&h->trava, ARQ_TRAVA_RESULTADOS);
+        fprintf(h->arquivo, "%ld;%016llx;%s;%s", r->momento, (unsigned long long)r->entrada, r->origem, r->mentorado);
+        for (int k = 0; k < r->total; k++) fprintf(h->arquivo, ";%s;%.3f", r->mentores[k], r->pontuacoes[k]);
+        fputc('\n', h->arquivo);
+        fflush(h->arquivo);
+        destravarArquivo(h->trava);
+    } else {
+        printf("Erro ao abrir %s para escrita.\n", ARQ_RESULTADOS);
+    }
+    h->itens[h->total] = *r;
+    indexarResultado(h, h->total++);
+}
+
+// Resultado de partida de um mentorado: os três primeiros candidatos do
+// pré-ranqueamento, com a pontuação local (origem "local")
+void resultadoLocal(ResultadoMentoria *r, const Mentorado *mentorado, uint64_t entrada, const Mentor *mentores,
+                    const CandidatoMentor *candidatos, int total) {
+    memset(r, 0, sizeof(*r));
+    r->entrada = entrada;
+    snprintf(r->origem, sizeof(r->origem), "local");
+    snprintf(r->mentorado, sizeof(r->mentorado), "%s", mentorado->nome);
+    for (int i = 0; i < total && r->total < MAX_RECOMENDADOS; i++) {
+        snprintf(r->mentores[r->total], sizeof(r->mentores[0]), "%s", mentores[candidatos[i].indice].nome);
+        r->pontuacoes[r->total++] = candidatos[i].pontuacao;
+    }
+}
+
+// "dd/mm/aaaa hh:mm — origem" e um mentor por linha
+void anexarResultado(TextoDinamico *texto, const ResultadoMentoria *r, const char *situacao) {
+    char data[32];
+    time_t momento = (time_t)r->momento;
+    strftime(data, sizeof(data), "%d/%m/%Y %H:%M", localtime(&momento));
+    anexarFormatado(texto, "%s — %s%s\n", data, r->origem, situacao);
+    if (r->total == 0) anexarString(texto, "  (resposta em texto livre)\n");
+    for (int k = 0; k < r->total; k++) anexarFormatado(texto, "  %d) %s — %.2f\n", k + 1, r->mentores[k], r->pontuacoes[k]);
+}
+
+// LIMITE DE TAXA E NOVAS TENTATIVAS
+
+LimitadorTaxa limitador_gemini = {0};
+
+void iniciarLimitador(LimitadorTaxa *l, int por_minuto) {
+    memset(l, 0, sizeof(*l));
+    if (por_minuto > 0) l->taxa = por_minuto / 60000.0;
+    l->capacidade = RAJADA_MAXIMA;
+    l->fichas = RAJADA_MAXIMA;
+    l->ultimo_ms = agoraMs();
+    srand((unsigned)time(NULL) ^ (unsigned)getpid());
+}
+
+// Consome uma ficha e retorna 0, ou retorna quantos ms faltam para haver uma
+long esperaParaEnvio(LimitadorTaxa *l) {
+    long agora = agoraMs();
+    if (agora < l->pausado_ate_ms) return l->pausado_ate_ms - agora;
+    if (l->taxa <= 0) return 0;
+    l->fichas += (agora - l->ultimo_ms) * l->taxa;
+    if (l->fichas > l->capacidade) l->fichas = l->capacidade;
+    l->ultimo_ms = agora;
+    if (l->fichas >= 1.0) {
+        l->fichas -= 1.0;
+        return 0;
+    }
+    return (long)ceil((1.0 - l->fichas) / l->taxa);
+}
+
+// Falhas que valem nova tentativa: cota (429), erros do servidor e de rede
+int falhaTransitoria(CURLcode res, long http_code) {
+    if (res == CURLE_OPERATION_TIMEDOUT || res == CURLE_COULDNT_CONNECT || res == CURLE_SEND_ERROR ||
+        res == CURLE_RECV_ERROR || res == CURLE_GOT_NOTHING || res == CURLE_PARTIAL_FILE) return 1;
+    if (res != CURLE_OK) return 0;
+    return http_code == 429 || http_code == 500 || http_code == 502 || http_code == 503 || http_code == 504;
+}
+
+// Espera antes da próxima tentativa: o Retry-After do servidor, se houver,
+// senão backoff exponencial com jitter (metade fixa, metade aleatória).
+// Um 429 pausa o limitador inteiro pelo mesmo período.
+long atrasoNovaTentativa(LimitadorTaxa *l, CURL *curl, long http_code, int tentativa) {
+    curl_off_t retry_after = -1;
+    curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retry_after);
+    long teto = ATRASO_BASE_MS;
+    for (int i = 1; i < tentativa && teto < ATRASO_MAXIMO_MS; i++) teto *= 2;
+    if (teto > ATRASO_MAXIMO_MS) teto = ATRASO_MAXIMO_MS;
+    long espera = teto / 2 + rand() % (teto / 2 + 1);
+    if (retry_after > 0) espera = (long)retry_after * 1000L + rand() % (ATRASO_BASE_MS + 1);
+    if (http_code == 429) {
+        long ate = agoraMs() + espera;
+        if (ate > l->pausado_ate_ms) l->pausado_ate_ms = ate;
+        l->fichas = 0;
+    }
+    return espera;
+}
+
+// RESPOSTAS ESTRUTURADAS
+// Leitura de JSON no próprio buffer (sem montar árvore), usada nas respostas
+// com responseSchema: a recomendação estruturada e a combinação agrupada.
+
+void pularEspacosJson(char **p) {
+    while (**p && isspace((unsigned char)**p)) (*p)++;
+}
+
+// Quatro dígitos hexadecimais de um \uXXXX; retorna 0 se algum não for válido
+int lerHex4(const char *s, unsigned *cp) {
+    *cp = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = tolower((unsigned char)s[i]);
+        if (!isxdigit(c)) return 0;
+        *cp = *cp * 16 + (unsigned)(isdigit(c) ? c - '0' : c - 'a' + 10);
+    }
+    return 1;
+}
+
+// Decodifica a string JSON que começa em *p (aspas) no próprio buffer: sem
+// os escapes ela nunca fica maior que o original. Avança *p para depois das
+// aspas finais e retorna o texto, ou NULL se a string não termina.
+char* lerStringNoLugar(char **p) {
+    char *r = *p + 1, *w = *p, *inicio = *p;
+    while (*r && *r != '"') {
+        if (*r != '\\') {
+            *w++ = *r++;
+            continue;
+        }
+        r++;
+        if (*r == 'u') {
+            unsigned cp, baixo;
+            if (!lerHex4(r + 1, &cp)) return NULL;
+            r += 5;
+            if (cp >= 0xD800 && cp <= 0xDBFF && r[0] == '\\' && r[1] == 'u' && lerHex4(r + 2, &baixo) && baixo >= 0xDC00 && baixo <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (baixo - 0xDC00);
+                r += 6;
+            }
+            if (cp < 0x80) *w++ = (char)cp;
+            else if (cp < 0x800) {
+                *w++ = (char)(0xC0 | (cp >> 6));
+                *w++ = (char)(0x80 | (cp & 0x3F));
+            } else if (cp < 0x10000) {
+                *w++ = (char)(0xE0 | (cp >> 12));
+                *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                *w++ = (char)(0x80 | (cp & 0x3F));
+            } else {
+                *w++ = (char)(0xF0 | (cp >> 18));
+                *w++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+                *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                *w++ = (char)(0x80 | (cp & 0x3F));
+            }
+            continue;
+        }
+        switch (*r) {
+            case 'n': *w++ = '\n'; break;
+            case 't': *w++ = '\t'; break;
+            case 'r': *w++ = '\r'; break;
+            case 'b': *w++ = '\b'; break;
+            case 'f': *w++ = '\f'; break;
+            case '\0': return NULL;
+            default:  *w++ = *r; break;  // \" \\ \/
+        }
+        r++;
+    }
+    if (*r != '"') return NULL;
+    *w = '\0';
+    *p = r + 1;
+    return inicio;
+}
+
+// Pula um valor JSON que não interessa; retorna 0 se o texto terminar antes
+int pularValorJson(char **p) {
+    pularEspacosJson(p);
+    if (**p == '"') return lerStringNoLugar(p) != NULL;
+    if (**p != '{' && **p != '[') {
+        while (**p && !strchr(",}] \t\r\n", **p)) (*p)++;  // número, true, false, null
+        return **p != '\0';
+    }
+    int profundidade = 0;
+    do {
+        if (**p == '"') {
+            if (!lerStringNoLugar(p)) return 0;
+            continue;
+        }
+        if (**p == '\0') return 0;
+        if (**p == '{' || **p == '[') profundidade++;
+        else if (**p == '}' || **p == ']') profundidade--;
+        (*p)++;
+    } while (profundidade > 0);
+    return 1;
+}
+
+// GEMINI_ESTRUTURADO=1 no ambiente: "Encontrar Mentor Ideal" pede a resposta
+// no formato de ESQUEMA_RECOMENDACAO em vez de texto livre
+int respostas_estruturadas = 0;
+
+static const char ESQUEMA_RECOMENDACAO[] =
+    "{\"type\":\"OBJECT\",\"properties\":{\"mentores\":{\"type\":\"ARRAY\",\"items\":{"
+    "\"type\":\"OBJECT\",\"properties\":{"
+    "\"mentor\":{\"type\":\"INTEGER\"},"
+    "\"pontuacao\":{\"type\":\"NUMBER\"},"
+    "\"motivo\":{\"type\":\"STRING\"}},"
+    "\"required\":[\"mentor\",\"pontuacao\",\"motivo\"]}}},"
+    "\"required\":[\"mentores\"]}";
+
+// Acrescenta ao prompt o pedido de resposta estruturada. Como o prompt é a
+// chave do cache, a resposta em JSON não se confunde com a de texto livre.
+char* pedirRespostaEstruturada(char *prompt) {
+    static const char sufixo[] = "\n\nResponda só com o JSON pedido: de 1 a 3 mentores da lista (campo mentor = número da lista), "
+                                 "uma nota de 0 a 10 para a compatibilidade e um motivo de uma frase.\n";
+    size_t tamanho = strlen(prompt);
+    char *estendido = realloc(prompt, tamanho + sizeof(sufixo));
+    if (!estendido) {
+        free(prompt);
+        return NULL;
+    }
+    memcpy(estendido + tamanho, sufixo, sizeof(sufixo));
+    return estendido;
+}
+
+CandidatosConsulta* copiarCandidatos(const Mentor *mentores, const Mentorado *mentorado, const CandidatoMentor *candidatos, int total,
+                                     uint64_t entrada) {
+    CandidatosConsulta *lista = malloc(sizeof(CandidatosConsulta));
+    if (!lista) return NULL;
+    lista->total = total < TOP_K_MENTORES ? total : TOP_K_MENTORES;
+    for (int i = 0; i < lista->total; i++) {
+        lista->ids[i] = candidatos[i].indice;
+        snprintf(lista->nomes[i], sizeof(lista->nomes[i]), "%s", mentores[candidatos[i].indice].nome);
+    }
+    resultadoLocal(&lista->local, mentorado, entrada, mentores, candidatos, total);
+    return lista;
+}
+
+// Um objeto {"mentor":3,"pontuacao":8.5,"motivo":"..."}; campos ausentes
+// ficam com mentor = 0 e pontuação NAN. Retorna 0 se o JSON terminar antes.
+int lerItemRecomendado(char **p, int *mentor, double *pontuacao, const char **motivo) {
+    *mentor = 0;
+    *pontuacao = NAN;
+    *motivo = "";
+    (*p)++;
+    while (1) {
+        pularEspacosJson(p);
+        if (**p == ',') {
+            (*p)++;
+            continue;
+        }
+        if (**p == '}') {
+            (*p)++;
+            return 1;
+        }
+        char *chave = **p == '"' ? lerStringNoLugar(p) : NULL;
+        if (!chave) return 0;
+        pularEspacosJson(p);
+        if (*(*p)++ != ':') return 0;
+        pularEspacosJson(p);
+        char *fim;
+        if (strcmp(chave, "mentor") == 0 && (isdigit((unsigned char)**p) || **p == '-')) {
+            *mentor = (int)strtol(*p, &fim, 10);
+            *p = fim;
+        } else if (strcmp(chave, "pontuacao") == 0 && (isdigit((unsigned char)**p) || **p == '-')) {
+            *pontuacao = strtod(*p, &fim);
+            *p = fim;
+        } else if (strcmp(chave, "motivo") == 0 && **p == '"') {
+            *motivo = lerStringNoLugar(p);
+            if (!*motivo) return 0;
+        } else if (!pularValorJson(p)) {
+            return 0;
+        }
+    }
+}
+
+// Lê {"mentores":[...]} e guarda em 'r' os itens válidos: mentor entre os
+// candidatos (sem repetição) e nota numérica, limitada a 0..10. Os itens
+// ficam em ordem decrescente de nota. Retorna quantos foram aceitos.
+int interpretarRecomendacao(char *texto, const CandidatosConsulta *candidatos, RecomendacaoEstruturada *r) {
+    r->total = 0;
+    char *p = strchr(texto, '{');  // tolera cercas de markdown antes do objeto
+    if (!p) return 0;
+    p++;
+    while (1) {
+        pularEspacosJson(&p);
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+        char *chave = *p == '"' ? lerStringNoLugar(&p) : NULL;
+        if (!chave) return r->total;
+        pularEspacosJson(&p);
+        if (*p++ != ':') return r->total;
+        pularEspacosJson(&p);
+        if (strcmp(chave, "mentores") != 0 || *p != '[') {
+            if (!pularValorJson(&p)) return r->total;
+            continue;
+        }
+        p++;
+        while (1) {
+            pularEspacosJson(&p);
+            if (*p == ',') {
+                p++;
+                continue;
+            }
+            if (*p != '{') return r->total;  // fim do array ou resposta truncada
+            int mentor;
+            double pontuacao;
+            const char *motivo;
+            if (!lerItemRecomendado(&p, &mentor, &pontuacao, &motivo)) return r->total;
+            int c = 0;
+            while (c < candidatos->total && candidatos->ids[c] + 1 != mentor) c++;
+            int repetido = 0;
+            for (int i = 0; i < r->total && !repetido; i++) repetido = r->itens[i].mentor + 1 == mentor;
+            if (c == candidatos->total || repetido || isnan(pontuacao) || r->total == MAX_RECOMENDADOS) continue;
+            if (pontuacao < 0) pontuacao = 0;
+            if (pontuacao > 10) pontuacao = 10;
+            // Inserção ordenada pela nota; a ordem do modelo desempata
+            int pos = r->total++;
+            while (pos > 0 && r->itens[pos - 1].pontuacao < pontuacao) {
+                r->itens[pos] = r->itens[pos - 1];
+                pos--;
+            }
+            MentorRecomendado *item = &r->itens[pos];
+            item->mentor = mentor - 1;
+            item->pontuacao = pontuacao;
+            snprintf(item->nome, sizeof(item->nome), "%s", candidatos->nomes[c]);
+            size_t n = strlen(motivo);
+            if (n >= sizeof(item->motivo)) {
+                n = sizeof(item->motivo) - 1;
+                while (n > 0 && ((unsigned char)motivo[n] & 0xC0) == 0x80) n--;  // não corta um caractere UTF-8
+            }
+            memcpy(item->motivo, motivo, n);
+            item->motivo[n] = '\0';
+        }
+    }
+}
+
+// Valida a resposta bruta (sem alterá-la) e retorna a recomendação, ou NULL
+// se nenhum item é aproveitável
+RecomendacaoEstruturada* lerRecomendacao(const char *resposta, const CandidatosConsulta *candidatos) {
+    char *copia = strdup(resposta);
+    RecomendacaoEstruturada *r = malloc(sizeof(RecomendacaoEstruturada));
+    if (!copia || !r || interpretarRecomendacao(copia, candidatos, r) == 0) {
+        free(copia);
+        free(r);
+        return NULL;
+    }
+    free(copia);
+    r->entrada = candidatos->local.entrada;
+    return r;
+}
+
+// Resultado para o histórico a partir da recomendação validada
+void resultadoDaRecomendacao(ResultadoMentoria *r, const CandidatosConsulta *candidatos, const RecomendacaoEstruturada *recomendacao) {
+    *r = candidatos->local;
+    snprintf(r->origem, sizeof(r->origem), "estruturada");
+    r->total = recomendacao->total;
+    for (int k = 0; k < recomendacao->total; k++) {
+        snprintf(r->mentores[k], sizeof(r->mentores[k]), "%s", recomendacao->itens[k].nome);
+        r->pontuacoes[k] = recomendacao->itens[k].pontuacao;
+    }
+}
+
+char* textoDaRecomendacao(const RecomendacaoEstruturada *r) {
+    TextoDinamico texto = {0};
+    int ok = anexarString(&texto, "Mentores recomendados (resposta estruturada):\n");
+    for (int i = 0; i < r->total && ok; i++) {
+        const MentorRecomendado *item = &r->itens[i];
+        ok = anexarFormatado(&texto, "\n%d) %s — nota %.1f/10\n   %s\n", item->mentor + 1, item->nome, item->pontuacao,
+                             item->motivo[0] ? item->motivo : "(sem motivo)");
+    }
+    if (!ok) {
+        liberarTexto(&texto);
+        return NULL;
+    }
+    return extrairTexto(&texto);
+}
+
+// CONSULTAS EM SEGUNDO PLANO
+
+FilaConsultas fila_consultas = {0};
+
+void iniciarFilaConsultas(FilaConsultas *fila, ClienteGemini *cliente, CacheRespostas *cache) {
+    memset(fila, 0, sizeof(*fila));
+    fila->cliente = cliente;
+    fila->cache = cache;
+    fila->multi = curl_multi_init();
+    if (fila->multi) curl_multi_setopt(fila->multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)CONCORRENCIA_PADRAO);
+}
+
+void devolverHandle(FilaConsultas *fila, Consulta *c) {
+    if (!c->curl) return;
+    if (c->enviada) curl_multi_remove_handle(fila->multi, c->curl);
+    c->enviada = 0;
+    curl_easy_setopt(c->curl, CURLOPT_POSTFIELDS, NULL);
+    if (fila->total_livres < CONCORRENCIA_PADRAO) fila->livres[fila->total_livres++] = c->curl;
+    else curl_easy_cleanup(c->curl);
+    c->curl = NULL;
+    free(c->corpo);
+    c->corpo = NULL;
+    fila->em_andamento--;
+}
+
+// Grava no histórico o resultado que a consulta exibiu
+void registrarConsulta(Consulta *c) {
+    if (!c->candidatos) return;
+    ResultadoMentoria r = c->candidatos->local;
+    if (c->recomendacao) {
+        resultadoDaRecomendacao(&r, c->candidatos, c->recomendacao);
+    } else if (c->estado == CONSULTA_CONCLUIDA) {
+        snprintf(r.origem, sizeof(r.origem), "texto");
+        r.total = 0;
+    }
+    registrarResultado(&historico_resultados, &r);
+}
+
+// Coloca a consulta na fila e retorna seu número (ou -1). Assume 'prompt',
+// 'alternativa' e 'candidatos'. Com 'estruturada', a resposta é pedida no
+// formato de ESQUEMA_RECOMENDACAO.
+int enfileirarConsulta(FilaConsultas *fila, const Mentorado *mentorados, int id_mentorado, char *prompt, char *alternativa,
+                       CandidatosConsulta *candidatos, int estruturada, double montagem_ms) {
+    Consulta *c = calloc(1, sizeof(Consulta));
+    if (!c || !reservarLista((void **)&fila->itens, fila->total, &fila->capacidade, sizeof(Consulta *))) {
+        free(c);
+        free(prompt);
+        free(alternativa);
+        free(candidatos);
+        return -1;
+    }
+    snprintf(c->mentorado, sizeof(c->mentorado), "%s", mentorados[id_mentorado].nome);
+    c->mentorado_id = id_mentorado;
+    c->prompt = prompt;
+    c->alternativa = alternativa;
+    c->candidatos = candidatos;
+    c->estruturada = estruturada && candidatos;
+    double inicio = cronometroMs();
+    c->corpo = c->estruturada ? montarCorpoComEsquema(prompt, ESQUEMA_RECOMENDACAO) : montarCorpoRequisicao(prompt);
+    c->montagem_ms = montagem_ms + (cronometroMs() - inicio);
+    c->inicio_ms = agoraMs();
+    if (fila->multi && fila->cliente->url && c->corpo) {
+        c->curl = fila->total_livres > 0 ? fila->livres[--fila->total_livres] : curl_easy_init();
+    }
+    if (c->curl) {
+        configurarHandleGemini(fila->cliente, c->curl);
+        prepararStream(fila->cliente, c->curl, &c->fluxo, c->corpo);
+        curl_easy_setopt(c->curl, CURLOPT_PRIVATE, (void *)c);
+        fila->em_andamento++;  // enviada por avancarConsultas, quando o limitador permitir
+        c->estado = CONSULTA_EM_ANDAMENTO;
+    } else {
+        // Sem cliente HTTP: a consulta já nasce com a recomendação local
+        free(c->corpo);
+        c->corpo = NULL;
+        c->estado = CONSULTA_LOCAL;
+        c->texto = c->alternativa;
+        c->alternativa = NULL;
+        registrarConsulta(c);
+    }
+    fila->itens[fila->total] = c;
+    return fila->total++;
+}
+
+// Envia as consultas cuja vez chegou, respeitando o limitador compartilhado
+void enviarConsultasPendentes(FilaConsultas *fila) {
+    long agora = agoraMs();
+    for (int i = 0; i < fila->total; i++) {
+        Consulta *c = fila->itens[i];
+        if (c->estado != CONSULTA_EM_ANDAMENTO || c->enviada || agora < c->proxima_ms) continue;
+        if (esperaParaEnvio(&limitador_gemini) > 0) return;
+        curl_multi_add_handle(fila->multi, c->curl);
+        c->enviada = 1;
+        c->tentativas++;
+    }
+}
+
+// Volta a consulta para a espera após uma falha transitória. O texto parcial
+// é descartado, mas quem está acompanhando continua acompanhando.
+void reagendarConsulta(FilaConsultas *fila, Consulta *c, long http_code) {
+    int desenhar = c->fluxo.desenhar, progresso = c->fluxo.progresso_na_tela;
+    curl_multi_remove_handle(fila->multi, c->curl);
+    c->enviada = 0;
+    c->ultimo_erro = http_code;
+    c->proxima_ms = agoraMs() + atrasoNovaTentativa(&limitador_gemini, c->curl, http_code, c->tentativas);
+    liberarStream(&c->fluxo);
+    prepararStream(fila->cliente, c->curl, &c->fluxo, c->corpo);
+    c->fluxo.desenhar = desenhar;
+    c->fluxo.progresso_na_tela = progresso;
+}
+
+// Avança as transferências sem bloquear. Retorna 1 se alguma consulta mudou de estado.
+int avancarConsultas(FilaConsultas *fila) {
+    if (!fila->multi || fila->em_andamento == 0) return 0;
+    int rodando = 0, mudou = 0, restantes;
+    enviarConsultasPendentes(fila);
+    curl_multi_perform(fila->multi, &rodando);
+    CURLMsg *msg;
+    while ((msg = curl_multi_info_read(fila->multi, &restantes))) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        Consulta *c = NULL;
+        long http_code = 0;
+        CURLcode res = msg->data.result;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&c);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &http_code);
+        mudou = 1;
+        // Só repete se nada foi exibido ainda: texto já desenhado não é refeito
+        // (no modo estruturado o JSON parcial nunca é desenhado)
+        if (falhaTransitoria(res, http_code) && (c->estruturada || c->fluxo.texto.tamanho == 0) && c->tentativas < MAX_TENTATIVAS) {
+            registrarMetrica(c->curl, res, http_code, "consulta", c->tentativas, c->montagem_ms, c->fluxo.tempo_interpretacao_ms);
+            reagendarConsulta(fila, c, http_code);
+            continue;
+        }
+        double inicio = cronometroMs();
+        char *texto = concluirStream(&c->fluxo, res, http_code);
+        registrarMetrica(c->curl, res, http_code, "consulta", c->tentativas, c->montagem_ms,
+                         c->fluxo.tempo_interpretacao_ms + (cronometroMs() - inicio));
+        devolverHandle(fila, c);
+        if (texto && c->estruturada) {
+            // Só uma resposta que passa na validação vai para o cache
+            c->recomendacao = lerRecomendacao(texto, c->candidatos);
+            if (c->recomendacao) gravarNoCache(fila->cache, c->prompt, texto);
+            free(texto);
+            texto = c->recomendacao ? textoDaRecomendacao(c->recomendacao) : NULL;
+        } else if (texto) {
+            gravarNoCache(fila->cache, c->prompt, texto);
+        }
+        if (texto) {
+            c->texto = texto;
+            c->estado = CONSULTA_CONCLUIDA;
+            free(c->alternativa);
+        } else {
+            c->texto = c->alternativa;
+            c->estado = CONSULTA_LOCAL;
+        }
+        registrarConsulta(c);
+        c->alternativa = NULL;
+        free(c->prompt);
+        c->prompt = NULL;
+    }
+    return mudou;
+}
+
+void cancelarConsulta(FilaConsultas *fila, Consulta *c) {
+    if (c->estado != CONSULTA_EM_ANDAMENTO) return;
+    devolverHandle(fila, c);
+    c->texto = c->alternativa;
+    c->alternativa = NULL;
+    c->estado = CONSULTA_CANCELADA;
+}
+
+// Passa as recomendações estruturadas prontas para os seus mentorados. Uma
+// compactação renumera os ids, então o nome confirma o dono (ou é procurado).
+void guardarRecomendacoes(FilaConsultas *fila, Mentorado *mentorados, int total) {
+    for (int i = 0; i < fila->total; i++) {
+        Consulta *c = fila->itens[i];
+        if (!c->recomendacao) continue;
+        int id = c->mentorado_id;
+        if (id >= total || !registroAtivo(&persistencia_mentorados, id) || strcmp(mentorados[id].nome, c->mentorado) != 0) {
+            for (id = 0; id < total; id++) {
+                if (registroAtivo(&persistencia_mentorados, id) && strcmp(mentorados[id].nome, c->mentorado) == 0) break;
+            }
+        }
+        if (id < total) {
+            free(mentorados[id].recomendacao);
+            mentorados[id].recomendacao = c->recomendacao;
+        } else {
+            free(c->recomendacao);  // mentorado removido nesse meio tempo
+        }
+        c->recomendacao = NULL;
+    }
+}
+
+void contarConsultas(const FilaConsultas *fila, int *em_andamento, int *nao_vistas) {
+    *em_andamento = *nao_vistas = 0;
+    for (int i = 0; i < fila->total; i++) {
+        if (fila->itens[i]->estado == CONSULTA_EM_ANDAMENTO) (*em_andamento)++;
+        else if (!fila->itens[i]->vista) (*nao_vistas)++;
+    }
+}
+
+void encerrarFilaConsultas(FilaConsultas *fila) {
+    for (int i = 0; i < fila->total; i++) {
+        Consulta *c = fila->itens[i];
+        cancelarConsulta(fila, c);
+        liberarStream(&c->fluxo);
+        free(c->prompt);
+        free(c->alternativa);
+        free(c->texto);
+        free(c->candidatos);
+        free(c->recomendacao);
+        free(c);
+    }
+    for (int i = 0; i < fila->total_livres; i++) curl_easy_cleanup(fila->livres[i]);
+    free(fila->itens);
+    if (fila->multi) curl_multi_cleanup(fila->multi);
+    memset(fila, 0, sizeof(*fila));
+}
+
+// ENTRADA DO TECLADO
+
+// Espera até 'limite_ms' (-1 = sem limite) por dados em stdin, avançando as
+// consultas pendentes. Retorna 1 se há entrada; 0 no limite ou quando uma
+// consulta termina (a tela deve ser atualizada).
+int esperarEntrada(int limite_ms) {
+    struct pollfd entrada = { STDIN_FILENO, POLLIN, 0 };
+    long inicio = agoraMs();
+    while (1) {
+        int espera = -1;
+        if (limite_ms >= 0) {
+            espera = limite_ms - (int)(agoraMs() - inicio);
+            if (espera < 0) espera = 0;
+        }
+        if (fila_consultas.em_andamento == 0) return poll(&entrada, 1, espera) > 0;
+        if (espera < 0 || espera > INTERVALO_CONSULTAS_MS) espera = INTERVALO_CONSULTAS_MS;
+        struct curl_waitfd extra = { STDIN_FILENO, CURL_WAIT_POLLIN, 0 };
+        curl_multi_poll(fila_consultas.multi, &extra, 1, espera, NULL);
+        if (extra.revents) return 1;
+        if (avancarConsultas(&fila_consultas)) return 0;
+        if (limite_ms >= 0 && agoraMs() - inicio >= limite_ms) return 0;
+    }
+}
+
+// Lê uma tecla sem eco. Retorna TECLA_ATUALIZAR se 'limite_ms' passar ou uma
+// consulta terminar antes de alguma tecla, e EOF no fim da entrada. As setas
+// vêm como TECLA_ACIMA etc., para telas em que W/S/A/D são texto digitado.
+int lerTeclaBruta(int limite_ms) {
+    struct termios oldt, newt;
+    unsigned char c;
+    int ch = TECLA_ATUALIZAR;
+    tcgetattr(STDIN_FILENO, &oldt);
+    newt = oldt;
+    newt.c_lflag &= ~(ICANON | ECHO);
+    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+    if (esperarEntrada(limite_ms)) ch = (read(STDIN_FILENO, &c, 1) == 1) ? c : EOF;
+    if (ch == 27) {
+        unsigned char seq[2] = {0, 0};
+        struct pollfd entrada = { STDIN_FILENO, POLLIN, 0 };
+        if (poll(&entrada, 1, 30) > 0 && read(STDIN_FILENO, &seq[0], 1) == 1 &&
+            poll(&entrada, 1, 30) > 0 && read(STDIN_FILENO, &seq[1], 1) == 1) {
+            if (seq[1] == 'A') ch = TECLA_ACIMA;
+            else if (seq[1] == 'B') ch = TECLA_ABAIXO;
+            else if (seq[1] == 'C') ch = TECLA_DIREITA;
+            else if (seq[1] == 'D') ch = TECLA_ESQUERDA;
+            else if (seq[1] == 'H') ch = TECLA_INICIO;
+            else if (seq[1] == 'F') ch = TECLA_FIM;
+            else if (seq[1] >= '1' && seq[1] <= '8') {
+                // ESC [ n ~ : PgUp (5), PgDn (6), Home (1/7), End (4/8)
+                unsigned char fim = 0;
+                if (poll(&entrada, 1, 30) > 0 && read(STDIN_FILENO, &fim, 1) == 1 && fim == '~') {
+                    if (seq[1] == '5') ch = TECLA_PAGINA_ACIMA;
+                    else if (seq[1] == '6') ch = TECLA_PAGINA_ABAIXO;
+                    else if (seq[1] == '1' || seq[1] == '7') ch = TECLA_INICIO;
+                    else if (seq[1] == '4' || seq[1] == '8') ch = TECLA_FIM;
+                }
+            }
+        }
+    }
+    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    return ch;
+}
+
+// Como lerTeclaBruta, mas as setas viram W/S/A/D (navegação dos menus)
+int lerTecla(int limite_ms) {
+    int ch = lerTeclaBruta(limite_ms);
+    if (ch == TECLA_ACIMA) return 'w';
+    if (ch == TECLA_ABAIXO) return 's';
+    if (ch == TECLA_DIREITA) return 'd';
+    if (ch == TECLA_ESQUERDA) return 'a';
+    return ch;
+}
+
+int capturaTecla() {
+    return lerTecla(-1);
+}
+
+// Lê uma linha de stdin (sem o '\n') sem travar as consultas em andamento.
+// A leitura é feita direto do descritor, sem o buffer do stdio, para não
+// misturar com lerTecla. Retorna 0 no fim da entrada.
+int lerLinha(char *buffer, int tamanho) {
+    int n = 0;
+    unsigned char c;
+    fflush(stdout);
+    while (1) {
+        if (!esperarEntrada(-1)) continue;
+        if (read(STDIN_FILENO, &c, 1) != 1) {
+            buffer[n] = '\0';
+            return n > 0;
+        }
+        if (c == '\n') break;
+        if (n < tamanho - 1) buffer[n++] = (char)c;
+    }
+    buffer[n] = '\0';
+    return 1;
+}
+
+void esperarPressionarQ() {
+    char input[10];
+    print_border_top();
+    print_line("Pressione 'q' para voltar ao menu...");
+    print_border_bottom();
+    do {
+        printf("> ");
+        if (!lerLinha(input, sizeof(input))) break;
+        if (input[0] == 'q' || input[0] == 'Q') break;
+    } while (1);
+}
+
+int confirmarRemocao(const char *mensagem) {
+    char input[10];
+    print_border_top();
+    print_line(mensagem);
+    print_line("Pressione 'y' para sim ou 'n' para não.");
+    print_border_bottom();
+    do {
+        printf("> ");
+        if (!lerLinha(input, sizeof(input))) return 0;
+        if (input[0] == 'y' || input[0] == 'Y') return 1;
+        if (input[0] == 'n' || input[0] == 'N') return 0;
+    } while (1);
+}
+
+// LISTAS COM ROLAGEM
+
+// Versões de print_border_top/print_line/print_border_bottom que escrevem
+// em um buffer, para a tela inteira sair em uma única escrita
+void anexarBorda(TextoDinamico *quadro, const char *esquerda, const char *direita) {
+    anexarString(quadro, esquerda);
+    for (int i = 0; i < WIDTH - 2; i++) anexarString(quadro, "═");
+    anexarString(quadro, direita);
+    anexarString(quadro, "\n");
+}
+
+void anexarLinhaCaixa(TextoDinamico *quadro, const char *texto) {
+    anexarString(quadro, "║");
+    anexarString(quadro, texto);
+    for (int j = visual_width(texto); j < WIDTH - 2; j++) anexarString(quadro, " ");
+    anexarString(quadro, "║\n");
+}
+
+// Corta 's' para caber em 'largura' colunas, sem partir caracteres UTF-8
+void truncarVisual(char *s, int largura) {
+    mbstate_t estado;
+    memset(&estado, 0, sizeof estado);
+    int usada = 0;
+    char *p = s;
+    while (*p) {
+        wchar_t wc;
+        size_t len = mbrtowc(&wc, p, MB_CUR_MAX, &estado);
+        int w = 1;
+        if (len == (size_t)-1 || len == (size_t)-2 || len == 0) {
+            len = 1;  // byte inválido no locale atual: conta como uma coluna
+            memset(&estado, 0, sizeof estado);
+        } else if (wcwidth(wc) >= 0) {
+            w = wcwidth(wc);
+        }
+        if (usada + w > largura) break;
+        usada += w;
+        p += len;
+    }
+    *p = '\0';
+}
+
+// Linhas de itens que cabem no terminal (24 linhas se o tamanho for desconhecido)
+int linhasDaLista() {
+    struct winsize ws;
+    int linhas = 24;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0) linhas = ws.ws_row;
+    linhas -= 9;  // bordas, título, filtro, espaço, posição e ajuda
+    return linhas < 3 ? 3 : linhas;
+}
+
+void escreverQuadro(const TextoDinamico *quadro) {
+    fflush(stdout);
+    size_t escrito = 0;
+    while (escrito < quadro->tamanho) {
+        ssize_t n = write(STDOUT_FILENO, quadro->dados + escrito, quadro->tamanho - escrito);
+        if (n <= 0) break;
+        escrito += (size_t)n;
+    }
+}
+
+typedef void (*FormatarItem)(const void *dados, int id, char *saida, size_t tamanho);
+
+void formatarItemMentor(const void *dados, int id, char *saida, size_t tamanho) {
+    const Mentor *m = &((const Mentor *)dados)[id];
+    if (m->vagas > 0) snprintf(saida, tamanho, "%s - %s (%d anos XP, %d vagas)", m->nome, m->area, m->experiencia, m->vagas);
+    else snprintf(saida, tamanho, "%s - %s (%d anos XP)", m->nome, m->area, m->experiencia);
+}
+
+void formatarItemMentorado(const void *dados, int id, char *saida, size_t tamanho) {
+    const Mentorado *m = &((const Mentorado *)dados)[id];
+    if (m->recomendacao) {
+        const MentorRecomendado *melhor = &m->recomendacao->itens[0];
+        snprintf(saida, tamanho, "%s - Objetivo: %s [-> %s, %.1f]", m->nome, m->objetivo, melhor->nome, melhor->pontuacao);
+    } else {
+        snprintf(saida, tamanho, "%s - Objetivo: %s", m->nome, m->objetivo);
+    }
+}
+
+// Texto em que o filtro procura: nome e área / nome e objetivo
+void textoBuscaMentor(const void *dados, int id, char *saida, size_t tamanho) {
+    const Mentor *m = &((const Mentor *)dados)[id];
+    snprintf(saida, tamanho, "%s %s", m->nome, m->area);
+}
+
+void textoBuscaMentorado(const void *dados, int id, char *saida, size_t tamanho) {
+    const Mentorado *m = &((const Mentorado *)dados)[id];
+    snprintf(saida, tamanho, "%s %s", m->nome, m->objetivo);
+}
+
+// Pares da atribuição global (dados = AtribuicaoMentores, id = mentorado)
+void formatarItemAtribuicao(const void *dados, int id, char *saida, size_t tamanho) {
+    const AtribuicaoMentores *a = (const AtribuicaoMentores *)dados;
+    const Mentorado *mentorado = &a->mentorados[id];
+    if (a->mentor[id] < 0) {
+        snprintf(saida, tamanho, "%s -> sem vaga", mentorado->nome);
+        return;
+    }
+    const Mentor *m = &a->mentores[a->mentor[id]];
+    snprintf(saida, tamanho, "%s -> %s (%.2f) - %s", mentorado->nome, m->nome, a->pontuacao[id], m->area);
+}
+
+void textoBuscaAtribuicao(const void *dados, int id, char *saida, size_t tamanho) {
+    const AtribuicaoMentores *a = (const AtribuicaoMentores *)dados;
+    const Mentor *m = a->mentor[id] >= 0 ? &a->mentores[a->mentor[id]] : NULL;
+    snprintf(saida, tamanho, "%s %s %s", a->mentorados[id].nome, m ? m->nome : "", m ? m->area : "");
+}
+
+// Último resultado de cada mentorado (dados = TelaHistorico, id = mentorado);
+// '*' marca os calculados com outras entradas
+void formatarItemHistorico(const void *dados, int id, char *saida, size_t tamanho) {
+    const TelaHistorico *tela = (const TelaHistorico *)dados;
+    const Mentorado *mentorado = &tela->mentorados[id];
+    const ResultadoMentoria *r = &historico_resultados.itens[ultimoResultado(&historico_resultados, mentorado->nome)];
+    const char *marca = r->entrada == tela->entradas[id] ? "" : "* ";
+    if (r->total > 0) snprintf(saida, tamanho, "%s%s -> %s (%.2f, %s)", marca, mentorado->nome, r->mentores[0], r->pontuacoes[0], r->origem);
+    else snprintf(saida, tamanho, "%s%s (%s)", marca, mentorado->nome, r->origem);
+}
+
+void textoBuscaHistorico(const void *dados, int id, char *saida, size_t tamanho) {
+    const TelaHistorico *tela = (const TelaHistorico *)dados;
+    const Mentorado *mentorado = &tela->mentorados[id];
+    const ResultadoMentoria *r = &historico_resultados.itens[ultimoResultado(&historico_resultados, mentorado->nome)];
+    snprintf(saida, tamanho, "%s %s", mentorado->nome, r->total > 0 ? r->mentores[0] : "");
+}
+
+// Ids ativos da lista, na ordem; o chamador libera. Calculado uma vez por
+// tela, para que cada tecla só formate as linhas visíveis.
+int* idsAtivos(const Persistencia *p, int total, int *quantidade) {
+    int *ids = malloc(((size_t)total + 1) * sizeof(int));
+    *quantidade = 0;
+    if (!ids) return NULL;
+    for (int i = 0; i < total; i++) if (registroAtivo(p, i)) ids[(*quantidade)++] = i;
+    return ids;
+}
+
+const char *texto_prefixos = NULL;  // base das palavras durante a ordenação
+
+int compararEntradasPrefixo(const void *a, const void *b) {
+    const EntradaPrefixo *x = a, *y = b;
+    int c = strcmp(texto_prefixos + x->palavra, texto_prefixos + y->palavra);
+    return c ? c : x->posicao - y->posicao;
+}
+
+// Indexa as palavras de cada item de 'ids' (uma vez por tela, ao começar a filtrar)
+int construirIndicePrefixos(IndicePrefixos *indice, const int *ids, int total, FormatarItem texto_busca, const void *dados) {
+    memset(indice, 0, sizeof(*indice));
+    for (int pos = 0; pos < total; pos++) {
+        char original[320];
+        char normal[320];
+        texto_busca(dados, ids[pos], original, sizeof(original));
+        normalizarTexto(original, normal, sizeof(normal));
+        for (char *p = normal; *p; ) {
+            while (*p && !isalnum((unsigned char)*p)) p++;
+            char *inicio = p;
+            while (isalnum((unsigned char)*p)) p++;
+            if (p == inicio) break;
+            if (!reservarLista((void **)&indice->entradas, indice->total, &indice->capacidade, sizeof(EntradaPrefixo))) return 0;
+            indice->entradas[indice->total].palavra = (uint32_t)indice->texto.tamanho;
+            indice->entradas[indice->total].posicao = pos;
+            indice->total++;
+            if (!anexarTexto(&indice->texto, inicio, (size_t)(p - inicio)) || !anexarTexto(&indice->texto, "", 1)) return 0;
+        }
     }
-    fclose(f);
-    return count;
+    texto_prefixos = indice->texto.dados;
+    qsort(indice->entradas, indice->total, sizeof(EntradaPrefixo), compararEntradasPrefixo);
+    return 1;
 }
 
-int carregarMentorados(Mentorado **lista) {
-    FILE *f = fopen(ARQ_MENTORADOS, "r");
-    if (!f) return 0;
-    int count = 0;
-    Mentorado temp;
-    while (fscanf(f, "%99[^;];%199[^\n]\n", temp.nome, temp.objetivo) == 2) {
-        Mentorado *res = realloc(*lista, sizeof(Mentorado) * (count + 1));
-        if (!res) { fclose(f); return count; }
-        *lista = res;
-        (*lista)[count++] = temp;
+void liberarIndicePrefixos(IndicePrefixos *indice) {
+    liberarTexto(&indice->texto);
+    free(indice->entradas);
+    memset(indice, 0, sizeof(*indice));
+}
+
+// Reduz [*inicio, *fim) às entradas que começam com 'prefixo'
+void faixaDoPrefixo(const IndicePrefixos *indice, const char *prefixo, int *inicio, int *fim) {
+    size_t tam = strlen(prefixo);
+    int lo = *inicio, hi = *fim;
+    while (lo < hi) {  // primeira entrada >= prefixo
+        int meio = lo + (hi - lo) / 2;
+        if (strcmp(indice->texto.dados + indice->entradas[meio].palavra, prefixo) < 0) lo = meio + 1;
+        else hi = meio;
     }
-    fclose(f);
-    return count;
+    int primeira = lo;
+    hi = *fim;
+    while (lo < hi) {  // primeira entrada que não começa com o prefixo
+        int meio = lo + (hi - lo) / 2;
+        if (strncmp(indice->texto.dados + indice->entradas[meio].palavra, prefixo, tam) <= 0) lo = meio + 1;
+        else hi = meio;
+    }
+    *inicio = primeira;
+    *fim = lo;
 }
 
-void salvarMentores(Mentor *lista, int total) {
-    FILE *f = fopen(ARQ_MENTORES, "w");
-    if (!f) return;
-    for (int i = 0; i < total; i++) {
-        fprintf(f, "%s;%s;%d\n", lista[i].nome, lista[i].area, lista[i].experiencia);
+void separarTermosFiltro(const char *filtro, FiltroLista *f) {
+    char normal[256];
+    normalizarTexto(filtro, normal, sizeof(normal));
+    f->total = 0;
+    for (char *p = normal; *p && f->total < MAX_TOKENS; ) {
+        while (*p && !isalnum((unsigned char)*p)) p++;
+        char *inicio = p;
+        while (isalnum((unsigned char)*p)) p++;
+        int len = (int)(p - inicio);
+        if (len == 0) break;
+        if (len >= TAM_TOKEN) len = TAM_TOKEN - 1;
+        memcpy(f->termos[f->total], inicio, len);
+        f->termos[f->total][len] = '\0';
+        f->total++;
     }
-    fclose(f);
 }
 
-void salvarMentorados(Mentorado *lista, int total) {
-    FILE *f = fopen(ARQ_MENTORADOS, "w");
-    if (!f) return;
-    for (int i = 0; i < total; i++) {
-        fprintf(f, "%s;%s\n", lista[i].nome, lista[i].objetivo);
+// Atualiza 'posicoes' (itens que casam com todos os termos) de 'anterior'
+// para 'novo'. Se cada termo anterior só ganhou letras no fim, o resultado
+// novo é subconjunto do anterior: cada faixa é buscada dentro da anterior e
+// só os itens ainda presentes são conferidos. Senão, recalcula do zero.
+void aplicarFiltro(const IndicePrefixos *indice, FiltroLista *anterior, FiltroLista *novo, int *posicoes, int *quantidade,
+                   int total, int *marca, int *selo) {
+    int refinamento = novo->total >= anterior->total;
+    for (int i = 0; i < anterior->total && refinamento; i++) {
+        refinamento = strncmp(novo->termos[i], anterior->termos[i], strlen(anterior->termos[i])) == 0;
     }
-    fclose(f);
+    if (!refinamento) {
+        for (int p = 0; p < total; p++) posicoes[p] = p;
+        *quantidade = total;
+    }
+    for (int t = 0; t < novo->total; t++) {
+        int herdada = refinamento && t < anterior->total;
+        novo->inicio[t] = herdada ? anterior->inicio[t] : 0;
+        novo->fim[t] = herdada ? anterior->fim[t] : indice->total;
+        if (herdada && strcmp(novo->termos[t], anterior->termos[t]) == 0) continue;  // já aplicado
+        faixaDoPrefixo(indice, novo->termos[t], &novo->inicio[t], &novo->fim[t]);
+        (*selo)++;
+        for (int e = novo->inicio[t]; e < novo->fim[t]; e++) marca[indice->entradas[e].posicao] = *selo;
+        int n = 0;
+        for (int k = 0; k < *quantidade; k++) if (marca[posicoes[k]] == *selo) posicoes[n++] = posicoes[k];
+        *quantidade = n;
+    }
+    *anterior = *novo;
 }
 
-int adicionarMentor(Mentor **lista, int total, Mentor novo) {
-    Mentor *res = realloc(*lista, sizeof(Mentor) * (total + 1));
-    if (!res) return total;
-    *lista = res;
-    (*lista)[total] = novo;
-    return total + 1;
+// Mostra 'ids' em uma janela do tamanho do terminal. Só as linhas visíveis
+// são formatadas e cada quadro sai em uma única escrita, então o custo por
+// tecla não depende do tamanho da lista. Com 'texto_busca', '/' abre um
+// filtro: o que for digitado restringe a lista às linhas com palavras que
+// começam com cada termo. Retorna o id escolhido com Enter (se
+// 'selecionavel') ou -1 ao voltar com Q.
+int percorrerLista(const char *titulo, const int *ids, int total, FormatarItem formatar, FormatarItem texto_busca,
+                   const void *dados, int selecionavel) {
+    TextoDinamico quadro = {0};
+    IndicePrefixos indice = {0};
+    FiltroLista filtro_atual = {0};
+    char filtro[128] = "";
+    int digitando = 0, indexado = 0, selo = 0;
+    int *posicoes = malloc(((size_t)total + 1) * sizeof(int));  // itens que passam pelo filtro
+    int *marca = calloc((size_t)total + 1, sizeof(int));
+    int visiveis = total;
+    int atual = 0, topo = 0, escolhido = -1;
+    if (!posicoes || !marca) {
+        free(posicoes);
+        free(marca);
+        return -1;
+    }
+    for (int p = 0; p < total; p++) posicoes[p] = p;
+
+    while (1) {
+        int altura = linhasDaLista();
+        if (atual >= visiveis) atual = visiveis ? visiveis - 1 : 0;
+        if (atual < topo) topo = atual;
+        if (atual >= topo + altura) topo = atual - altura + 1;
+        if (topo > visiveis - altura) topo = visiveis - altura;
+        if (topo < 0) topo = 0;
+
+        quadro.tamanho = 0;
+        anexarString(&quadro, "\033[H\033[2J");  // mesmo efeito de system("clear"), sem criar processo
+        anexarBorda(&quadro, "╔", "╗");
+        anexarLinhaCaixa(&quadro, titulo);
+        char linha_filtro[200] = "";
+        if (digitando || filtro[0]) {
+            snprintf(linha_filtro, sizeof(linha_filtro), "Filtro: %s%s", filtro, digitando ? "_" : "");
+            truncarVisual(linha_filtro, WIDTH - 2);
+        }
+        anexarLinhaCaixa(&quadro, linha_filtro);
+        for (int r = topo; r < visiveis && r < topo + altura; r++) {
+            char item[300];
+            char linha[320];
+            formatar(dados, ids[posicoes[r]], item, sizeof(item));
+            truncarVisual(item, WIDTH - 7);  // cabe com " < " e " >"
+            if (r == atual) snprintf(linha, sizeof(linha), " < %s >", item);
+            else snprintf(linha, sizeof(linha), " %s ", item);
+            anexarLinhaCaixa(&quadro, linha);
+        }
+        if (visiveis == 0) anexarLinhaCaixa(&quadro, " Nenhum item corresponde ao filtro.");
+        anexarLinhaCaixa(&quadro, "");
+        char posicao[80];
+        snprintf(posicao, sizeof(posicao), "Itens %d-%d de %d", visiveis ? topo + 1 : 0,
+                 topo + altura < visiveis ? topo + altura : visiveis, visiveis);
+        if (visiveis != total) snprintf(posicao + strlen(posicao), sizeof(posicao) - strlen(posicao), " (filtrados de %d)", total);
+        anexarLinhaCaixa(&quadro, posicao);
+        if (digitando) {
+            anexarLinhaCaixa(&quadro, "Digite para filtrar por nome, área ou objetivo.");
+            anexarLinhaCaixa(&quadro, "Enter: confirmar, Esc: limpar, setas: navegar.");
+        } else {
+            anexarLinhaCaixa(&quadro, "W/S: linha, A/D ou PgUp/PgDn: página, g/G: início/fim.");
+            if (texto_busca) anexarLinhaCaixa(&quadro, selecionavel ? "/: filtrar, Enter: escolher, Q: voltar." : "/: filtrar, Q: voltar.");
+            else anexarLinhaCaixa(&quadro, selecionavel ? "Enter: escolher, Q: voltar." : "Q: voltar.");
+        }
+        anexarBorda(&quadro, "╚", "╝");
+        escreverQuadro(&quadro);
+
+        int tecla = lerTeclaBruta(-1);
+        if (tecla == EOF) break;
+        if (tecla == TECLA_ACIMA) tecla = 'w';
+        else if (tecla == TECLA_ABAIXO) tecla = 's';
+        else if (tecla == TECLA_ESQUERDA) tecla = TECLA_PAGINA_ACIMA;
+        else if (tecla == TECLA_DIREITA) tecla = TECLA_PAGINA_ABAIXO;
+        else if (digitando) {
+            size_t len = strlen(filtro);
+            if (tecla == '\n') {
+                digitando = 0;
+                continue;
+            }
+            if (tecla == 27) {
+                digitando = 0;
+                filtro[0] = '\0';
+            } else if (tecla == 127 || tecla == 8) {
+                // Apaga o último caractere (com os bytes de continuação UTF-8)
+                while (len > 0 && ((unsigned char)filtro[len - 1] & 0xC0) == 0x80) len--;
+                if (len > 0) len--;
+                filtro[len] = '\0';
+            } else if (tecla >= 32 && tecla < 256 && len + 1 < sizeof(filtro)) {
+                filtro[len] = (char)tecla;
+                filtro[len + 1] = '\0';
+            } else {
+                continue;
+            }
+            FiltroLista novo;
+            separarTermosFiltro(filtro, &novo);
+            aplicarFiltro(&indice, &filtro_atual, &novo, posicoes, &visiveis, total, marca, &selo);
+            atual = 0;
+            continue;
+        }
+        if (tecla == 'q' || tecla == 'Q') break;
+        if (tecla == '/' && texto_busca) {
+            if (!indexado) indexado = construirIndicePrefixos(&indice, ids, total, texto_busca, dados);
+            if (indexado) digitando = 1;
+            continue;
+        }
+        if (visiveis == 0) continue;
+        if (tecla == 'w') atual = (atual - 1 + visiveis) % visiveis;
+        else if (tecla == 's') atual = (atual + 1) % visiveis;
+        else if (tecla == 'a' || tecla == TECLA_PAGINA_ACIMA) atual = atual > altura ? atual - altura : 0;
+        else if (tecla == 'd' || tecla == TECLA_PAGINA_ABAIXO) atual = atual + altura < visiveis ? atual + altura : visiveis - 1;
+        else if (tecla == 'g' || tecla == TECLA_INICIO) atual = 0;
+        else if (tecla == 'G' || tecla == TECLA_FIM) atual = visiveis - 1;
+        else if (tecla == '\n' && selecionavel) {
+            escolhido = ids[posicoes[atual]];
+            break;
+        }
+    }
+    liberarTexto(&quadro);
+    liberarIndicePrefixos(&indice);
+    free(posicoes);
+    free(marca);
+    return escolhido;
 }
 
-int adicionarMentorado(Mentorado **lista, int total, Mentorado novo) {
-    Mentorado *res = realloc(*lista, sizeof(Mentorado) * (total + 1));
-    if (!res) return total;
-    *lista = res;
-    (*lista)[total] = novo;
-    return total + 1;
+// TELAS DAS CONSULTAS
+
+const char* descreverEstado(const Consulta *c) {
+    switch (c->estado) {
+        case CONSULTA_EM_ANDAMENTO: return "em andamento";
+        case CONSULTA_CONCLUIDA:    return "pronta";
+        case CONSULTA_LOCAL:        return "recomendação local";
+        case CONSULTA_CANCELADA:    return "cancelada";
+    }
+    return "";
 }
 
-int removerMentor(Mentor **lista, int total, int indice) {
-    if (indice < 0 || indice >= total) return total;
-    for (int i = indice; i < total - 1; i++) {
-        (*lista)[i] = (*lista)[i + 1];
+// Acompanha uma consulta: o texto aparece conforme chega. 'c' cancela e
+// 'q' volta ao menu sem interromper a consulta.
+void acompanharConsulta(FilaConsultas *fila, int id) {
+    static const char giro[] = "|/-\\";
+    Consulta *c = fila->itens[id];
+    system("clear");
+    char titulo[160];
+    snprintf(titulo, sizeof(titulo), "Mentor ideal para %s", c->mentorado);
+    mostrarTextoMultiline(titulo);
+
+    int exibida = 0;
+    if (c->estado == CONSULTA_EM_ANDAMENTO) {
+        RespostaStream *fluxo = &c->fluxo;
+        fluxo->caixa_aberta = fluxo->linha_aberta = fluxo->coluna = 0;
+        // JSON parcial não é desenhado: a recomendação estruturada aparece formatada no fim
+        if (!c->estruturada) {
+            if (fluxo->texto.tamanho > 0) escreverNaCaixa(fluxo, fluxo->texto.dados, fluxo->texto.tamanho);
+            fluxo->desenhar = 1;
+        }
+        int passo = 0;
+        while (c->estado == CONSULTA_EM_ANDAMENTO) {
+            if (!fluxo->caixa_aberta) {
+                char situacao[80] = "Consultando o modelo (Gemini)...";
+                long falta = c->proxima_ms - agoraMs();
+                if (!c->enviada && falta > 0) {
+                    char erro[32] = "falha de rede";
+                    if (c->ultimo_erro > 0) snprintf(erro, sizeof(erro), "HTTP %ld", c->ultimo_erro);
+                    snprintf(situacao, sizeof(situacao), "%s; nova tentativa (%d/%d) em %.1f s...",
+                             erro, c->tentativas + 1, MAX_TENTATIVAS, falta / 1000.0);
+                } else if (!c->enviada) {
+                    snprintf(situacao, sizeof(situacao), "Aguardando o limite de requisições...");
+                }
+                printf("\r%c %s %.1f s   [c: cancelar | q: voltar ao menu]\033[K",
+                       giro[passo++ % 4], situacao, (agoraMs() - c->inicio_ms) / 1000.0);
+                fluxo->progresso_na_tela = 1;
+            }
+            fflush(stdout);
+            int tecla = lerTecla(INTERVALO_CONSULTAS_MS);
+            if (tecla == 'c' || tecla == 'C') {
+                cancelarConsulta(fila, c);
+            } else if (tecla == 'q' || tecla == 'Q' || tecla == EOF) {
+                fluxo->desenhar = 0;
+                fluxo->progresso_na_tela = 0;
+                return;  // a consulta continua em segundo plano
+            }
+        }
+        fluxo->desenhar = 0;
+        if (fluxo->progresso_na_tela) printf("\r\033[K");
+        fluxo->progresso_na_tela = 0;
+        if (fluxo->caixa_aberta) {
+            exibida = (c->estado == CONSULTA_CONCLUIDA);
+            if (!exibida) escreverNaCaixa(fluxo, "\n[resposta interrompida]", strlen("\n[resposta interrompida]"));
+            fecharCaixaStream(fluxo);
+        }
     }
-    if (total - 1 == 0) {
-        free(*lista);
-        *lista = NULL;
-        return 0;
+    if (c->estado == CONSULTA_CANCELADA) mostrarTextoMultiline("Consulta cancelada.");
+    if (!exibida) {
+        // Sem resposta do modelo: mostra o ranqueamento local
+        if (c->texto) mostrarTextoMultiline(c->texto);
+        else mostrarTextoMultiline("Erro: falha ao chamar a API do Gemini ou resposta vazia.\n");
     }
-    Mentor *res = realloc(*lista, sizeof(Mentor) * (total - 1));
-    if (res || total == 1) *lista = res;
-    return total - 1;
+    c->vista = 1;
+    esperarPressionarQ();
 }
 
-int removerMentorado(Mentorado **lista, int total, int indice) {
-    if (indice < 0 || indice >= total) return total;
-    for (int i = indice; i < total - 1; i++) {
-        (*lista)[i] = (*lista)[i + 1];
-    }
-    if (total - 1 == 0) {
-        free(*lista);
-        *lista = NULL;
-        return 0;
+// Lista as consultas da sessão; Enter abre, 'c' cancela, 'q' volta
+void listarConsultas(FilaConsultas *fila) {
+    int selecionada = fila->total - 1;
+    while (1) {
+        system("clear");
+        print_border_top();
+        print_line("Consultas ao Modelo:");
+        print_line("");
+        if (fila->total == 0) print_line("Nenhuma consulta nesta sessão.");
+        for (int i = 0; i < fila->total; i++) {
+            const Consulta *c = fila->itens[i];
+            char linha[200];
+            char buffer[250];
+            if (c->estado == CONSULTA_EM_ANDAMENTO) {
+                snprintf(linha, sizeof(linha), "[%s, %.0f s] %s", descreverEstado(c), (agoraMs() - c->inicio_ms) / 1000.0, c->mentorado);
+            } else {
+                snprintf(linha, sizeof(linha), "[%s%s] %s", descreverEstado(c), c->vista ? "" : ", nova", c->mentorado);
+            }
+            if (i == selecionada) snprintf(buffer, sizeof(buffer), " < %s >", linha);
+            else snprintf(buffer, sizeof(buffer), " %s ", linha);
+            print_line(buffer);
+        }
+        print_line("");
+        print_line("W/S navegam, Enter abre, C cancela, Q volta.");
+        print_border_bottom();
+        int tecla = lerTecla(fila->em_andamento > 0 ? 1000 : -1);
+        if (tecla == 'q' || tecla == 'Q' || tecla == EOF) return;
+        if (fila->total == 0) continue;
+        if (tecla == 'w') selecionada = (selecionada - 1 + fila->total) % fila->total;
+        else if (tecla == 's') selecionada = (selecionada + 1) % fila->total;
+        else if (tecla == 'c' || tecla == 'C') cancelarConsulta(fila, fila->itens[selecionada]);
+        else if (tecla == '\n') acompanharConsulta(fila, selecionada);
     }
-    Mentorado *res = realloc(*lista, sizeof(Mentorado) * (total - 1));
-    if (res || total == 1) *lista = res;
-    return total - 1;
 }
 
-// FUNÇÕES DA API DO GEMINI
+// RESPOSTAS AGRUPADAS
+// No modo agrupado, um prompt leva vários mentorados: as instruções e cada
+// mentor aparecem uma vez só, e o modelo responde um array JSON no formato
+// de ESQUEMA_AGRUPADO, separado aqui por mentorado.
 
-static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
-    size_t realsize = size * nmemb;
-    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
-    char *ptr = realloc(mem->memory, mem->size + realsize + 1);
-    if (ptr == NULL) return 0;
-    mem->memory = ptr;
-    memcpy(&(mem->memory[mem->size]), contents, realsize);
-    mem->size += realsize;
-    mem->memory[mem->size] = 0;
-    return realsize;
-}
+static const char ESQUEMA_AGRUPADO[] =
+    "{\"type\":\"ARRAY\",\"items\":{\"type\":\"OBJECT\",\"properties\":{"
+    "\"mentorado\":{\"type\":\"INTEGER\"},"
+    "\"mentores\":{\"type\":\"ARRAY\",\"items\":{\"type\":\"INTEGER\"}},"
+    "\"justificativa\":{\"type\":\"STRING\"}},"
+    "\"required\":[\"mentorado\",\"mentores\",\"justificativa\"]}}";
 
-char* chamarGemini(const char *url, const char *prompt) {
-    CURL *curl;
-    CURLcode res;
-    long http_code = 0;
-    struct MemoryStruct chunk;
-    chunk.memory = malloc(1);
-    chunk.size = 0;
-
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(stderr, "Erro: falha ao inicializar cURL\n");
-        free(chunk.memory);
+// Chave do cache no modo agrupado: o prompt individual com um sufixo, para
+// não se confundir com a resposta em texto livre do mesmo mentorado
+char* chaveAgrupada(char *prompt) {
+    static const char sufixo[] = "\n[resposta agrupada]";
+    size_t tamanho = strlen(prompt);
+    char *chave = realloc(prompt, tamanho + sizeof(sufixo));
+    if (!chave) {
+        free(prompt);
         return NULL;
     }
+    memcpy(chave + tamanho, sufixo, sizeof(sufixo));
+    return chave;
+}
 
-    cJSON *root = cJSON_CreateObject();
-    cJSON *contents = cJSON_AddArrayToObject(root, "contents");
-    cJSON *content = cJSON_CreateObject();
-    cJSON_AddItemToArray(contents, content);
-    cJSON_AddStringToObject(content, "role", "user");
-    cJSON *parts = cJSON_AddArrayToObject(content, "parts");
-    cJSON *part = cJSON_CreateObject();
-    cJSON_AddItemToArray(parts, part);
-    cJSON_AddStringToObject(part, "text", prompt);
-
-    char *json_str = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
+// Instruções de prompt.txt (o texto antes do primeiro marcador), candidatos
+// de todos os mentorados do slot sem repetição e os mentorados numerados,
+// cada um com os números dos seus candidatos
+char* montarPromptAgrupado(const ModeloPrompt *modelo, const Mentor *mentores, const Mentorado *mentorados, const TransferenciaLote *t) {
+    TextoDinamico prompt = {0};
+    int listados[MAX_MENTORADOS_POR_REQUISICAO * TOP_K_MENTORES];
+    int total_listados = 0;
+    int ok = reservarTexto(&prompt, modelo->tamanho_literais + 512 + (size_t)t->total * (400 + TOP_K_MENTORES * 160));
+    for (int i = 0; i < modelo->total && modelo->trechos[i].tipo == TRECHO_LITERAL && ok; i++) {
+        ok = anexarTexto(&prompt, modelo->trechos[i].texto, modelo->trechos[i].tamanho);
+    }
+    ok = ok && anexarString(&prompt, "\n\nMentores disponiveis:\n");
+    for (int j = 0; j < t->total && ok; j++) {
+        for (int c = 0; c < t->totalCandidatos[j] && ok; c++) {
+            int id = t->candidatos[j][c].indice, repetido = 0;
+            for (int l = 0; l < total_listados && !repetido; l++) repetido = listados[l] == id;
+            if (repetido) continue;
+            listados[total_listados++] = id;
+            const Mentor *m = &mentores[id];
+            ok = anexarFormatado(&prompt, "%d) %s — Area: %s, XP: %d anos\n", id + 1, m->nome, m->area, m->experiencia);
+        }
+    }
+    ok = ok && anexarString(&prompt, "\nMentorados:\n");
+    for (int j = 0; j < t->total && ok; j++) {
+        const Mentorado *mentorado = &mentorados[t->mentorados[j]];
+        ok = anexarFormatado(&prompt, "[%d] %s — Objetivo: %s — Candidatos:", j + 1, mentorado->nome, mentorado->objetivo);
+        for (int c = 0; c < t->totalCandidatos[j] && ok; c++) {
+            ok = anexarFormatado(&prompt, "%s %d", c ? "," : "", t->candidatos[j][c].indice + 1);
+        }
+        ok = ok && anexarString(&prompt, "\n");
+    }
+    ok = ok && anexarString(&prompt, "\nPara cada mentorado, indique de 1 a 3 mentores entre os seus candidatos (pelo número da lista) "
+                                     "e justifique a escolha em poucas frases, com um primeiro passo sugerido. "
+                                     "Responda só com o JSON pedido, um item por mentorado (campo mentorado = número entre colchetes).\n");
+    if (!ok) {
+        liberarTexto(&prompt);
+        return NULL;
+    }
+    return extrairTexto(&prompt);
+}
 
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_str);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
+// Lê [{"mentorado":1,"mentores":[3,17],"justificativa":"..."}, ...] sem
+// montar árvore: só esses três campos são interpretados e o resto é pulado.
+// Cercas de markdown antes do array são toleradas. Retorna quantos itens
+// completos foram lidos, ou -1 se não há array.
+int interpretarRespostaAgrupada(char *texto, ItemRespostaAgrupada *itens, int max) {
+    char *p = strchr(texto, '[');
+    if (!p) return -1;
+    p++;
+    int n = 0;
+    while (1) {
+        pularEspacosJson(&p);
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+        if (*p != '{') return n;  // fim do array ou resposta truncada
+        p++;
+        ItemRespostaAgrupada item = {.mentorado = -1};
+        while (1) {
+            pularEspacosJson(&p);
+            if (*p == ',') {
+                p++;
+                continue;
+            }
+            if (*p == '}') {
+                p++;
+                break;
+            }
+            char *chave = *p == '"' ? lerStringNoLugar(&p) : NULL;
+            if (!chave) return n;
+            pularEspacosJson(&p);
+            if (*p++ != ':') return n;
+            pularEspacosJson(&p);
+            if (strcmp(chave, "mentorado") == 0 && (isdigit((unsigned char)*p) || *p == '-')) {
+                item.mentorado = (int)strtol(p, &p, 10);
+            } else if (strcmp(chave, "mentores") == 0 && *p == '[') {
+                p++;
+                while (1) {
+                    pularEspacosJson(&p);
+                    if (*p == ',') {
+                        p++;
+                        continue;
+                    }
+                    if (*p == ']') {
+                        p++;
+                        break;
+                    }
+                    char *fim;
+                    long numero = strtol(p, &fim, 10);
+                    if (fim == p) return n;
+                    p = fim;
+                    if (item.total_mentores < 3) item.mentores[item.total_mentores++] = (int)numero;
+                }
+            } else if (strcmp(chave, "justificativa") == 0 && *p == '"') {
+                item.justificativa = lerStringNoLugar(&p);
+                if (!item.justificativa) return n;
+            } else if (!pularValorJson(&p)) {
+                return n;
+            }
+        }
+        if (n < max) itens[n++] = item;
+    }
+}
 
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+// Texto de um mentorado a partir do seu item. Só contam mentores que estavam
+// entre os candidatos dele; se nenhum estava, retorna NULL. Os mentores
+// aceitos vão para 'resultado', com a pontuação local de cada um.
+char* textoDoItemAgrupado(const Mentor *mentores, const ItemRespostaAgrupada *item, const CandidatoMentor *candidatos, int totalCandidatos,
+                          ResultadoMentoria *resultado) {
+    TextoDinamico texto = {0};
+    int validos = 0, ok = anexarString(&texto, "Mentores indicados:\n");
+    resultado->total = 0;
+    for (int k = 0; k < item->total_mentores && ok; k++) {
+        for (int c = 0; c < totalCandidatos; c++) {
+            if (candidatos[c].indice + 1 != item->mentores[k]) continue;
+            const Mentor *m = &mentores[candidatos[c].indice];
+            ok = anexarFormatado(&texto, "%d) %s — %s, %d anos XP\n", item->mentores[k], m->nome, m->area, m->experiencia);
+            if (resultado->total < MAX_RECOMENDADOS) {
+                snprintf(resultado->mentores[resultado->total], sizeof(resultado->mentores[0]), "%s", m->nome);
+                resultado->pontuacoes[resultado->total++] = candidatos[c].pontuacao;
+            }
+            validos++;
+            break;
+        }
+    }
+    if (ok && item->justificativa) ok = anexarFormatado(&texto, "\n%s\n", item->justificativa);
+    if (!ok || validos == 0) {
+        liberarTexto(&texto);
+        return NULL;
+    }
+    return extrairTexto(&texto);
+}
 
-    res = curl_easy_perform(curl);
+// COMBINAÇÃO EM LOTE
 
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+void registrarResultadoLote(FILE *relatorio, const Mentorado *mentorado, const char *origem, const char *texto) {
+    if (!relatorio) return;
+    fprintf(relatorio, "=== %s ===\nObjetivo: %s\nOrigem: %s\n\n%s\n\n", mentorado->nome, mentorado->objetivo, origem, texto);
+    fflush(relatorio);
+}
 
-    if (res != CURLE_OK) {
-        fprintf(stderr, "cURL error: %s\n", curl_easy_strerror(res));
-        if (chunk.size > 0 && chunk.memory) {
-            fprintf(stderr, "Resposta bruta (quando cURL falhou):\n%s\n", chunk.memory);
+// Combina todos os mentorados usando curl_multi com até 'concorrencia'
+// requisições simultâneas, cada uma com até 'por_requisicao' mentorados
+// (mais de 1: prompt agrupado e resposta em JSON). Cada resultado é gravado
+// no relatório e no histórico assim que fica pronto. Mentorados com
+// resultado no histórico para as mesmas entradas são pulados antes do
+// pré-ranqueamento, e os já em cache não entram nas requisições. Os envios passam pelo limitador compartilhado, falhas
+// transitórias são repetidas com backoff e só os mentorados sem resposta
+// utilizável recebem a recomendação local. Com 'atribuicao', cada mentorado
+// leva só o mentor já escolhido para ele e o modelo apenas justifica o par.
+void combinarTodosMentorados(ClienteGemini *cliente, CacheRespostas *cache, const ModeloPrompt *modelo, const Mentor *mentores, int totalMentores,
+                             const Mentorado *mentorados, int totalMentorados, int concorrencia, int por_requisicao,
+                             const AtribuicaoMentores *atribuicao) {
+    FILE *relatorio = fopen(ARQ_RELATORIO, "w");
+    if (!relatorio) {
+        printf("Erro ao abrir %s para escrita.\n", ARQ_RELATORIO);
+        return;
+    }
+    CURLM *multi = curl_multi_init();
+    TransferenciaLote *slots = calloc(concorrencia, sizeof(TransferenciaLote));
+    if (!multi || !slots) {
+        printf("Erro: falha ao inicializar a combinação em lote.\n");
+        if (multi) curl_multi_cleanup(multi);
+        free(slots);
+        fclose(relatorio);
+        return;
+    }
+    curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)concorrencia);
+    int handles = 0;
+    for (int s = 0; s < concorrencia; s++) {
+        slots[s].curl = curl_easy_init();
+        if (slots[s].curl) {
+            configurarHandleGemini(cliente, slots[s].curl);
+            curl_easy_setopt(slots[s].curl, CURLOPT_PRIVATE, (void *)&slots[s]);
+            handles++;
         }
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-        free(json_str);
-        free(chunk.memory);
-        return NULL;
+    }
+    // Sem nenhum handle, nenhum slot receberia mentorados e o laço não terminaria
+    if (handles == 0) {
+        printf("Erro: falha ao inicializar as conexões da combinação em lote.\n");
+        curl_multi_cleanup(multi);
+        free(slots);
+        fclose(relatorio);
+        return;
     }
 
-    if (http_code >= 400) {
-        fprintf(stderr, "HTTP error: %ld\n", http_code);
-        if (chunk.size > 0 && chunk.memory) {
-            fprintf(stderr, "Resposta bruta:\n%s\n", chunk.memory);
-
-            cJSON *resp = cJSON_Parse(chunk.memory);
-            if (resp) {
-                cJSON *error = cJSON_GetObjectItem(resp, "error");
-                if (error) {
-                    cJSON *msg = cJSON_GetObjectItem(error, "message");
-                    cJSON *code = cJSON_GetObjectItem(error, "code");
-                    cJSON *status = cJSON_GetObjectItem(error, "status");
-                    if (msg) fprintf(stderr, "API error.message: %s\n", cJSON_GetStringValue(msg));
-                    if (code) {
-                        if (cJSON_IsNumber(code)) fprintf(stderr, "API error.code: %d\n", code->valueint);
-                        else fprintf(stderr, "API error.code: %s\n", cJSON_GetStringValue(code));
-                    }
-                    if (status) fprintf(stderr, "API error.status: %s\n", cJSON_GetStringValue(status));
+    int agrupado = por_requisicao > 1;
+    ItemRespostaAgrupada itens[2 * MAX_MENTORADOS_POR_REQUISICAO];
+    uint64_t versao = versaoDasEntradas(mentores, totalMentores, modelo);
+    int proximo = 0, ocupados = 0, concluidos = 0, do_cache = 0, inalterados = 0, falhas = 0, repetidas = 0, requisicoes = 0;
+    int alvo = totalAtivos(&persistencia_mentorados, totalMentorados);
+    while (concluidos < alvo) {
+        // Preenche os slots livres com os próximos mentorados
+        for (int s = 0; s < concorrencia && proximo < totalMentorados; s++) {
+            TransferenciaLote *t = &slots[s];
+            if (t->total > 0 || !t->curl) continue;
+            double inicio = cronometroMs();
+            while (proximo < totalMentorados && t->total < por_requisicao) {
+                int i = proximo++;
+                if (!registroAtivo(&persistencia_mentorados, i)) continue;
+                if (atribuicao && atribuicao->mentor[i] < 0) {
+                    registrarResultadoLote(relatorio, &mentorados[i], "sem vaga", "Nenhum mentor com vaga disponível.");
+                    concluidos++;
+                    continue;
+                }
+                uint64_t entrada = entradaDoMentorado(&mentorados[i], versao);
+                const ResultadoMentoria *anterior = resultadoAtual(&historico_resultados, mentorados[i].nome, entrada,
+                                                                   atribuicao ? mentores[atribuicao->mentor[i]].nome : NULL);
+                if (anterior) {
+                    TextoDinamico resumo = {0};
+                    anexarResultado(&resumo, anterior, "");
+                    registrarResultadoLote(relatorio, &mentorados[i], "inalterado (histórico)", resumo.dados ? resumo.dados : "");
+                    liberarTexto(&resumo);
+                    inalterados++;
+                    concluidos++;
+                    continue;
+                }
+                int j = t->total;
+                char *prompt;
+                if (atribuicao) {
+                    CandidatoMentor *par = &t->candidatos[j][0];
+                    par->indice = atribuicao->mentor[i];
+                    par->pontuacao = atribuicao->pontuacao[i];
+                    motivoDoPar(&mentores[par->indice], &mentorados[i], par->motivo, sizeof(par->motivo));
+                    t->totalCandidatos[j] = 1;
+                    prompt = montarPromptComCandidatos(modelo, mentores, &mentorados[i], t->candidatos[j], 1);
                 } else {
-                    cJSON *errMsg = cJSON_GetObjectItem(resp, "errorMessage");
-                    if (errMsg) fprintf(stderr, "API errorMessage: %s\n", cJSON_GetStringValue(errMsg));
+                    prompt = montarPromptMentoria(modelo, mentores, totalMentores, &mentorados[i], t->candidatos[j], &t->totalCandidatos[j]);
                 }
-                cJSON_Delete(resp);
+                char *chave = prompt && agrupado ? chaveAgrupada(prompt) : prompt;
+                char *texto = chave ? buscarNoCache(cache, chave) : NULL;
+                if (!chave || texto) {
+                    registrarResultadoLote(relatorio, &mentorados[i], texto ? "cache" : "erro", texto ? texto : "Erro ao montar o prompt.");
+                    if (texto) do_cache++;
+                    else falhas++;
+                    concluidos++;
+                    free(texto);
+                    free(chave);
+                    continue;
+                }
+                t->mentorados[j] = i;
+                t->chaves[j] = chave;
+                t->entradas[j] = entrada;
+                t->total++;
+            }
+            if (t->total == 0) continue;
+            if (agrupado) {
+                char *prompt = montarPromptAgrupado(modelo, mentores, mentorados, t);
+                t->corpo = prompt ? montarCorpoComEsquema(prompt, ESQUEMA_AGRUPADO) : NULL;
+                free(prompt);
             } else {
-                fprintf(stderr, "Resposta não é JSON válido.\n");
+                t->corpo = montarCorpoRequisicao(t->chaves[0]);
             }
-        } else {
-            fprintf(stderr, "Nenhuma resposta do servidor.\n");
+            if (!t->corpo) {
+                for (int j = 0; j < t->total; j++) {
+                    registrarResultadoLote(relatorio, &mentorados[t->mentorados[j]], "erro", "Erro ao montar o prompt.");
+                    free(t->chaves[j]);
+                    falhas++;
+                    concluidos++;
+                }
+                t->total = 0;
+                continue;
+            }
+            t->montagem_ms = cronometroMs() - inicio;
+            t->tentativas = 0;
+            t->proxima_ms = 0;
+            curl_easy_setopt(t->curl, CURLOPT_POSTFIELDS, t->corpo);
+            curl_easy_setopt(t->curl, CURLOPT_WRITEDATA, (void *)&t->resposta);
+            ocupados++;
         }
+        if (ocupados == 0) continue;
 
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-        free(json_str);
-        free(chunk.memory);
-        return NULL;
-    }
+        // Envia o que estiver liberado; 'espera' limita o poll até o próximo envio
+        long espera = 1000;
+        for (int s = 0; s < concorrencia; s++) {
+            TransferenciaLote *t = &slots[s];
+            if (t->total == 0 || t->enviada) continue;
+            long falta = t->proxima_ms - agoraMs();
+            if (falta <= 0) falta = esperaParaEnvio(&limitador_gemini);
+            if (falta > 0) {
+                if (falta < espera) espera = falta;
+                continue;
+            }
+            iniciarResposta(&t->resposta, t->curl);
+            curl_multi_add_handle(multi, t->curl);
+            t->enviada = 1;
+            t->tentativas++;
+            requisicoes++;
+        }
 
-    cJSON *response = cJSON_Parse(chunk.memory);
-    if (response) {
-        cJSON *candidates = cJSON_GetObjectItem(response, "candidates");
-        if (candidates && cJSON_GetArraySize(candidates) > 0) {
-            cJSON *candidate = cJSON_GetArrayItem(candidates, 0);
-            cJSON *content_resp = cJSON_GetObjectItem(candidate, "content");
-            if (content_resp) {
-                cJSON *parts_resp = cJSON_GetObjectItem(content_resp, "parts");
-                if (parts_resp && cJSON_GetArraySize(parts_resp) > 0) {
-                    cJSON *part_resp = cJSON_GetArrayItem(parts_resp, 0);
-                    cJSON *text = cJSON_GetObjectItem(part_resp, "text");
-                    if (text) {
-                        char *result = strdup(cJSON_GetStringValue(text));
-                        cJSON_Delete(response);
-                        curl_slist_free_all(headers);
-                        curl_easy_cleanup(curl);
-                        free(json_str);
-                        free(chunk.memory);
-                        return result;
+        int rodando = 0;
+        curl_multi_perform(multi, &rodando);
+        CURLMsg *msg;
+        int restantes, terminou = 0;
+        while ((msg = curl_multi_info_read(multi, &restantes))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            terminou = 1;
+            CURLcode res = msg->data.result;
+            CURL *easy = msg->easy_handle;
+            TransferenciaLote *t = NULL;
+            long http_code = 0;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, (char **)&t);
+            curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &http_code);
+            curl_multi_remove_handle(multi, easy);
+            t->enviada = 0;
+            if (falhaTransitoria(res, http_code) && t->tentativas < MAX_TENTATIVAS) {
+                registrarMetrica(easy, res, http_code, "lote", t->tentativas, t->montagem_ms, t->resposta.tempo_interpretacao_ms);
+                t->proxima_ms = agoraMs() + atrasoNovaTentativa(&limitador_gemini, easy, http_code, t->tentativas);
+                repetidas++;
+                continue;
+            }
+
+            double inicio = cronometroMs();
+            char *texto = interpretarResposta(res, http_code, &t->resposta);
+            int lidos = texto && agrupado ? interpretarRespostaAgrupada(texto, itens, 2 * MAX_MENTORADOS_POR_REQUISICAO) : 0;
+            registrarMetrica(easy, res, http_code, "lote", t->tentativas, t->montagem_ms,
+                             t->resposta.tempo_interpretacao_ms + (cronometroMs() - inicio));
+            if (agrupado && texto && lidos < 0) fprintf(stderr, "Resposta agrupada sem array JSON:\n%s\n", texto);
+            for (int j = 0; j < t->total; j++) {
+                const Mentorado *mentorado = &mentorados[t->mentorados[j]];
+                ResultadoMentoria historico;
+                resultadoLocal(&historico, mentorado, t->entradas[j], mentores, t->candidatos[j], t->totalCandidatos[j]);
+                char *resultado = NULL;
+                if (!agrupado) {
+                    resultado = texto;
+                    texto = NULL;
+                    historico.total = 0;  // texto livre: os mentores não são identificados
+                    snprintf(historico.origem, sizeof(historico.origem), "texto");
+                }
+                for (int k = 0; k < lidos && !resultado; k++) {
+                    if (itens[k].mentorado != j + 1) continue;
+                    resultado = textoDoItemAgrupado(mentores, &itens[k], t->candidatos[j], t->totalCandidatos[j], &historico);
+                    snprintf(historico.origem, sizeof(historico.origem), "agrupada");
+                }
+                if (resultado) {
+                    // Na atribuição o par já estava decidido: o modelo só o justifica
+                    if (atribuicao) {
+                        resultadoLocal(&historico, mentorado, t->entradas[j], mentores, t->candidatos[j], 1);
+                        snprintf(historico.origem, sizeof(historico.origem), "atribuicao");
                     }
+                    gravarNoCache(cache, t->chaves[j], resultado);
+                    registrarResultadoLote(relatorio, mentorado, "modelo", resultado);
+                } else {
+                    resultado = recomendacaoLocal(mentores, mentorado, t->candidatos[j], t->totalCandidatos[j]);
+                    registrarResultadoLote(relatorio, mentorado, lidos > 0 ? "local (ausente na resposta)" : "local (falha na API)",
+                                           resultado ? resultado : "");
+                    resultadoLocal(&historico, mentorado, t->entradas[j], mentores, t->candidatos[j], t->totalCandidatos[j]);
+                    falhas++;
                 }
+                registrarResultado(&historico_resultados, &historico);
+                free(resultado);
+                free(t->chaves[j]);
+                concluidos++;
             }
+            free(texto);
+            free(t->corpo);
+            t->corpo = NULL;
+            t->total = 0;
+            ocupados--;
         }
-        fprintf(stderr, "Resposta JSON recebida, mas campo esperado não encontrado. Resposta bruta:\n%s\n", chunk.memory);
-        cJSON_Delete(response);
-    } else {
-        fprintf(stderr, "Erro ao parsear JSON de resposta.\n");
-        if (chunk.size > 0) fprintf(stderr, "Resposta bruta:\n%s\n", chunk.memory);
+        printf("\rConcluídos: %d/%d (requisições: %d, inalterados: %d, cache: %d, falhas: %d, novas tentativas: %d)   ",
+               concluidos, alvo, requisicoes, inalterados, do_cache, falhas, repetidas);
+        fflush(stdout);
+        // Slots liberados ou reagendados são tratados na próxima volta, sem esperar
+        if (!terminou && concluidos < alvo) curl_multi_poll(multi, NULL, 0, (int)espera, NULL);
     }
+    // Totais finais (sem nenhuma requisição, o laço não chega a mostrá-los)
+    printf("\rConcluídos: %d/%d (requisições: %d, inalterados: %d, cache: %d, falhas: %d, novas tentativas: %d)   \n",
+           concluidos, alvo, requisicoes, inalterados, do_cache, falhas, repetidas);
 
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-    free(json_str);
-    free(chunk.memory);
-    return NULL;
+    for (int s = 0; s < concorrencia; s++) {
+        if (slots[s].curl) curl_easy_cleanup(slots[s].curl);
+        liberarResposta(&slots[s].resposta);
+    }
+    curl_multi_cleanup(multi);
+    free(slots);
+    fclose(relatorio);
 }
 
-char* carregarPromptBase() {
-    FILE *f = fopen(ARQ_PROMPT, "r");
-    if (!f) {
-        const char *def = "Você é um mentor virtual que ajuda a combinar mentorados com mentores com base em experiência, área e objetivo profissional. Dê recomendações claras e razões.";
-        return strdup(def);
-    }
-    fseek(f, 0, SEEK_END);
-    long sz = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    char *buf = malloc(sz + 1);
-    if (!buf) { fclose(f); return strdup(""); }
-    fread(buf, 1, sz, f);
-    buf[sz] = '\0';
-    fclose(f);
-    return buf;
+// Grava os pares em ARQ_ATRIBUICAO (mentorado;mentor;área;pontuação)
+int gravarAtribuicao(const AtribuicaoMentores *a, int totalMentorados) {
+    FILE *f = fopen(ARQ_ATRIBUICAO, "w");
+    if (!f) return 0;
+    for (int i = 0; i < totalMentorados; i++) {
+        if (!registroAtivo(&persistencia_mentorados, i)) continue;
+        if (a->mentor[i] < 0) {
+            fprintf(f, "%s;;;\n", a->mentorados[i].nome);
+            continue;
+        }
+        const Mentor *m = &a->mentores[a->mentor[i]];
+        fprintf(f, "%s;%s;%s;%.3f\n", a->mentorados[i].nome, m->nome, m->area, a->pontuacao[i]);
+    }
+    return fclose(f) == 0;
+}
+
+// Atribuição global: calcula, resume e, se pedido, manda só os pares
+// escolhidos ao modelo para a justificativa
+void telaAtribuicaoGlobal(ClienteGemini *cliente, CacheRespostas *cache, const ModeloPrompt *modelo, const Mentor *mentores, int totalMentores,
+                          const Mentorado *mentorados, int totalMentorados) {
+    print_border_top();
+    print_line("Atribuição Global com Vagas");
+    print_border_bottom();
+    char entrada[16];
+    int vagas = VAGAS_PADRAO;
+    printf("Vagas por mentor sem limite próprio [%d]: ", VAGAS_PADRAO);
+    if (lerLinha(entrada, sizeof(entrada)) && atoi(entrada) > 0) vagas = atoi(entrada);
+    AtribuicaoMentores a;
+    if (!atribuirMentores(mentores, totalMentores, mentorados, totalMentorados, vagas, &a)) {
+        liberarAtribuicao(&a);
+        printf("Erro: memória insuficiente para a atribuição.\n");
+        esperarPressionarQ();
+        return;
+    }
+    int gravado = gravarAtribuicao(&a, totalMentorados);
+
+    while (1) {
+        char linha[300];
+        system("clear");
+        print_border_top();
+        print_line("Atribuição Global com Vagas");
+        print_line("");
+        snprintf(linha, sizeof(linha), "Mentorados atendidos: %d de %d", a.atribuidos, a.atribuidos + a.sem_vaga);
+        print_line(linha);
+        snprintf(linha, sizeof(linha), "Mentores com mentorados: %d de %d", a.mentores_usados, totalAtivos(&persistencia_mentores, totalMentores));
+        print_line(linha);
+        snprintf(linha, sizeof(linha), "Pontuação média: %.2f", a.atribuidos ? a.soma_pontuacao / a.atribuidos : 0.0);
+        print_line(linha);
+        if (a.mais_procurado >= 0) {
+            snprintf(linha, sizeof(linha), "Sem limite, %d iriam para %s", a.maior_demanda, mentores[a.mais_procurado].nome);
+            print_line(linha);
+        }
+        snprintf(linha, sizeof(linha), "Tempo: %.0f ms (áreas) + %.0f ms (fluxo)", a.candidatos_ms, a.fluxo_ms);
+        print_line(linha);
+        print_line(gravado ? "Pares salvos em " ARQ_ATRIBUICAO : "Erro ao gravar " ARQ_ATRIBUICAO);
+        print_line("");
+        print_line("L: ver pares  J: justificar com o modelo  Q: voltar");
+        print_border_bottom();
+        int tecla = capturaTecla();
+        if (tecla == 'l' || tecla == 'L') {
+            int ativos = 0;
+            int *ids = idsAtivos(&persistencia_mentorados, totalMentorados, &ativos);
+            if (ids) percorrerLista("Pares da atribuição:", ids, ativos, formatarItemAtribuicao, textoBuscaAtribuicao, &a, 0);
+            free(ids);
+        } else if (tecla == 'j' || tecla == 'J') {
+            system("clear");
+            combinarTodosMentorados(cliente, cache, modelo, mentores, totalMentores, mentorados, totalMentorados, CONCORRENCIA_PADRAO,
+                                    MENTORADOS_POR_REQUISICAO, &a);
+            mostrarTextoMultiline("Justificativas salvas em " ARQ_RELATORIO ".");
+            esperarPressionarQ();
+        } else if (tecla == 'q' || tecla == 'Q' || tecla == EOF) {
+            break;
+        }
+    }
+    liberarAtribuicao(&a);
+}
+
+// Último resultado de cada mentorado com histórico; Enter mostra os
+// anteriores dele. A lista sai do índice, sem reler o arquivo.
+void telaHistorico(const Mentor *mentores, int totalMentores, const ModeloPrompt *modelo, const Mentorado *mentorados, int totalMentorados) {
+    uint64_t versao = versaoDasEntradas(mentores, totalMentores, modelo);
+    uint64_t *entradas = malloc(((size_t)totalMentorados + 1) * sizeof(uint64_t));
+    int *ids = malloc(((size_t)totalMentorados + 1) * sizeof(int));
+    int total = 0;
+    for (int i = 0; entradas && ids && i < totalMentorados; i++) {
+        if (!registroAtivo(&persistencia_mentorados, i) || ultimoResultado(&historico_resultados, mentorados[i].nome) < 0) continue;
+        entradas[i] = entradaDoMentorado(&mentorados[i], versao);
+        ids[total++] = i;
+    }
+    if (total == 0) {
+        print_border_top();
+        print_line("Nenhum resultado no histórico.");
+        print_border_bottom();
+        esperarPressionarQ();
+    }
+    TelaHistorico tela = {mentorados, entradas};
+    int escolhido;
+    while (total > 0 && (escolhido = percorrerLista("Histórico (* = entradas mudaram desde o resultado):", ids, total, formatarItemHistorico,
+                                                     textoBuscaHistorico, &tela, 1)) >= 0) {
+        TextoDinamico texto = {0};
+        anexarFormatado(&texto, "Resultados de %s (mais recentes primeiro):\n", mentorados[escolhido].nome);
+        int id = ultimoResultado(&historico_resultados, mentorados[escolhido].nome);
+        for (int mostrados = 0; id >= 0 && mostrados < 20; mostrados++) {
+            const ResultadoMentoria *r = &historico_resultados.itens[id];
+            anexarString(&texto, "\n");
+            anexarResultado(&texto, r, r->entrada == entradas[escolhido] ? " (atual)" : "");
+            id = r->anterior;
+        }
+        system("clear");
+        mostrarTextoMultiline(texto.dados ? texto.dados : "Erro: memória insuficiente.");
+        liberarTexto(&texto);
+        esperarPressionarQ();
+    }
+    free(entradas);
+    free(ids);
 }
 
 // PROGRAMA PRINCIPAL
@@ -422,6 +4786,19 @@ char* carregarPromptBase() {
 int main() {
     setlocale(LC_ALL, "");
     curl_global_init(CURL_GLOBAL_DEFAULT);
+    ClienteGemini cliente;
+    if (!inicializarClienteGemini(&cliente, GEMINI_URL)) encerrarClienteGemini(&cliente);
+    ModeloPrompt modelo;
+    compilarModeloPrompt(&modelo, ARQ_PROMPT);
+    CacheRespostas cache;
+    abrirCache(&cache, &modelo);
+    abrirHistorico(&historico_resultados);
+    iniciarFilaConsultas(&fila_consultas, &cliente, &cache);
+    // GEMINI_RPM no ambiente ajusta o limite à cota da chave (0 desativa)
+    const char *rpm = getenv("GEMINI_RPM");
+    iniciarLimitador(&limitador_gemini, rpm && rpm[0] ? atoi(rpm) : REQUISICOES_POR_MINUTO);
+    const char *estruturado = getenv("GEMINI_ESTRUTURADO");
+    respostas_estruturadas = estruturado && atoi(estruturado) == 1;
     Mentor *mentores = NULL;
     Mentorado *mentorados = NULL;
     int totalMentores = carregarMentores(&mentores);
@@ -434,12 +4811,22 @@ int main() {
         "Remover Mentor",
         "Remover Mentorado",
         "Encontrar Mentor Ideal",
+        "Busca Local por Similaridade",
+        "Combinar Todos os Mentorados",
+        "Atribuição Global com Vagas",
+        "Consultas ao Modelo",
+        "Histórico de Recomendações",
+        "Métricas do Modelo",
         "Sair"
     };
-    int total_opcoes = 8;
+    int total_opcoes = 14;
     int selected = 0;
     int running = 1;
     while (running) {
+        // Cadastros e remoções feitos por outras sessões desde a última volta
+        totalMentores = sincronizarMentores(&mentores, totalMentores);
+        totalMentorados = sincronizarMentorados(&mentorados, totalMentorados);
+        guardarRecomendacoes(&fila_consultas, mentorados, totalMentorados);
         system("clear");
         print_border_top();
         print_line(" <=== SISTEMA DE MENTORIA ===>");
@@ -451,38 +4838,64 @@ int main() {
             print_line(buffer);
         }
         print_line("");
+        int em_andamento, prontas;
+        contarConsultas(&fila_consultas, &em_andamento, &prontas);
+        if (em_andamento > 0 || prontas > 0) {
+            char status[120];
+            snprintf(status, sizeof(status), "Consultas: %d em andamento, %d pronta(s) para ver", em_andamento, prontas);
+            print_line(status);
+        }
         print_line("Use as setas ou W/S para navegar. Enter para selecionar.");
         print_border_bottom();
-        int tecla = capturaTecla();
-        if (tecla == 'w') selected = (selected - 1 + total_opcoes) % total_opcoes;
+        // Com consultas pendentes, o menu é redesenhado quando uma termina
+        int tecla = lerTecla(em_andamento > 0 ? 1000 : -1);
+        if (tecla == EOF) running = 0;
+        else if (tecla == 'w') selected = (selected - 1 + total_opcoes) % total_opcoes;
         else if (tecla == 's') selected = (selected + 1) % total_opcoes;
         else if (tecla == '\n') {
             system("clear");
             switch (selected) {
                 case 0: {
-                    // Listar Mentores
-                    print_border_top();
-                    print_line("Lista de Mentores:");
-                    for (int i = 0; i < totalMentores; i++) {
-                        char linha[200];
-                        snprintf(linha, sizeof(linha), "%s - %s (%d anos XP)", mentores[i].nome, mentores[i].area, mentores[i].experiencia);
-                        print_line(linha);
+                    // Listar Mentores (opcionalmente só os de uma área, via índice)
+                    char filtro[100] = "";
+                    printf("Filtrar por área (Enter para listar todos): ");
+                    lerLinha(filtro, sizeof(filtro));
+                    const GrupoArea *grupo = NULL;
+                    int exibidos = totalMentores;
+                    if (filtro[0]) {
+                        grupo = grupoDaArea(filtro);
+                        exibidos = grupo ? grupo->total : 0;
                     }
-                    print_border_bottom();
-                    esperarPressionarQ();
+                    int *ids = malloc(((size_t)exibidos + 1) * sizeof(int));
+                    int listados = 0;
+                    for (int j = 0; ids && j < exibidos; j++) {
+                        int i = grupo ? grupo->ids[j] : j;
+                        if (registroAtivo(&persistencia_mentores, i)) ids[listados++] = i;
+                    }
+                    if (listados == 0) {
+                        print_border_top();
+                        print_line("Nenhum mentor encontrado.");
+                        print_border_bottom();
+                        esperarPressionarQ();
+                    } else {
+                        percorrerLista(filtro[0] ? "Mentores da área:" : "Lista de Mentores:", ids, listados, formatarItemMentor, textoBuscaMentor, mentores, 0);
+                    }
+                    free(ids);
                     break;
                 }
                 case 1: {
                     // Listar Mentorados
-                    print_border_top();
-                    print_line("Lista de Mentorados:");
-                    for (int i = 0; i < totalMentorados; i++) {
-                        char linha[200];
-                        snprintf(linha, sizeof(linha), "%s - Objetivo: %s", mentorados[i].nome, mentorados[i].objetivo);
-                        print_line(linha);
+                    int listados = 0;
+                    int *ids = idsAtivos(&persistencia_mentorados, totalMentorados, &listados);
+                    if (listados == 0) {
+                        print_border_top();
+                        print_line("Nenhum mentorado cadastrado.");
+                        print_border_bottom();
+                        esperarPressionarQ();
+                    } else {
+                        percorrerLista("Lista de Mentorados:", ids, listados, formatarItemMentorado, textoBuscaMentorado, mentorados, 0);
                     }
-                    print_border_bottom();
-                    esperarPressionarQ();
+                    free(ids);
                     break;
                 }
                 case 2: {
@@ -491,17 +4904,16 @@ int main() {
                     print_border_top();
                     print_line("Cadastro de Mentor");
                     print_border_bottom();
+                    char entrada[16];
                     printf("Nome: ");
-                    fgets(novo.nome, sizeof(novo.nome), stdin);
-                    novo.nome[strcspn(novo.nome, "\n")] = 0;
+                    lerLinha(novo.nome, sizeof(novo.nome));
                     printf("Área: ");
-                    fgets(novo.area, sizeof(novo.area), stdin);
-                    novo.area[strcspn(novo.area, "\n")] = 0;
+                    lerLinha(novo.area, sizeof(novo.area));
                     printf("Anos de experiência: ");
-                    if (scanf("%d", &novo.experiencia) != 1) novo.experiencia = 0;
-                    getchar();  // limpar buffer
+                    if (!lerLinha(entrada, sizeof(entrada)) || sscanf(entrada, "%d", &novo.experiencia) != 1) novo.experiencia = 0;
+                    printf("Vagas para mentorados (Enter = padrão): ");
+                    if (!lerLinha(entrada, sizeof(entrada)) || sscanf(entrada, "%d", &novo.vagas) != 1 || novo.vagas < 0) novo.vagas = 0;
                     totalMentores = adicionarMentor(&mentores, totalMentores, novo);
-                    salvarMentores(mentores, totalMentores);
                     print_border_top();
                     print_line("Mentor cadastrado com sucesso!");
                     print_border_bottom();
@@ -510,18 +4922,15 @@ int main() {
                 }
                 case 3: {
                     // Adicionar Mentorado
-                    Mentorado novo;
+                    Mentorado novo = {0};
                     print_border_top();
                     print_line("Cadastro de Mentorado");
                     print_border_bottom();
                     printf("Nome: ");
-                    fgets(novo.nome, sizeof(novo.nome), stdin);
-                    novo.nome[strcspn(novo.nome, "\n")] = 0;
+                    lerLinha(novo.nome, sizeof(novo.nome));
                     printf("Objetivo profissional: ");
-                    fgets(novo.objetivo, sizeof(novo.objetivo), stdin);
-                    novo.objetivo[strcspn(novo.objetivo, "\n")] = 0;
+                    lerLinha(novo.objetivo, sizeof(novo.objetivo));
                     totalMentorados = adicionarMentorado(&mentorados, totalMentorados, novo);
-                    salvarMentorados(mentorados, totalMentorados);
                     print_border_top();
                     print_line("Mentorado cadastrado com sucesso!");
                     print_border_bottom();
@@ -530,110 +4939,64 @@ int main() {
                 }
                 case 4: {
                     // Remover Mentor
-                    if (totalMentores == 0) {
+                    if (totalAtivos(&persistencia_mentores, totalMentores) == 0) {
                         print_border_top();
                         print_line("Nenhum mentor cadastrado para remover.");
                         print_border_bottom();
                         esperarPressionarQ();
                         break;
                     }
-                    int selected_mentor = 0;
-                    int selecting = 1;
-                    while (selecting) {
-                        system("clear");
+                    int ativos = 0;
+                    int *ids = idsAtivos(&persistencia_mentores, totalMentores, &ativos);
+                    int selected_mentor = percorrerLista("Selecione o Mentor a Remover:", ids, ativos, formatarItemMentor, textoBuscaMentor, mentores, 1);
+                    free(ids);
+                    if (selected_mentor < 0) break;
+                    char msg[200];
+                    snprintf(msg, sizeof(msg), "Deseja remover o mentor '%s'?", mentores[selected_mentor].nome);
+                    if (confirmarRemocao(msg)) {
+                        totalMentores = removerMentor(&mentores, totalMentores, selected_mentor);
                         print_border_top();
-                        print_line("Selecione o Mentor a Remover:");
-                        print_line("");
-                        for (int i = 0; i < totalMentores; i++) {
-                            char linha[200];
-                            char buffer[250];
-                            snprintf(linha, sizeof(linha), "%s - %s (%d anos XP)", mentores[i].nome, mentores[i].area, mentores[i].experiencia);
-                            if (i == selected_mentor) snprintf(buffer, sizeof(buffer), " < %s >", linha);
-                            else snprintf(buffer, sizeof(buffer), " %s ", linha);
-                            print_line(buffer);
-                        }
-                        print_line("");
-                        print_line("Use as setas ou W/S para navegar. Enter para selecionar.");
+                        print_line("Mentor removido com sucesso.");
                         print_border_bottom();
-                        int tecla2 = capturaTecla();
-                        if (tecla2 == 'w') selected_mentor = (selected_mentor - 1 + totalMentores) % totalMentores;
-                        else if (tecla2 == 's') selected_mentor = (selected_mentor + 1) % totalMentores;
-                        else if (tecla2 == '\n') {
-                            char msg[200];
-                            snprintf(msg, sizeof(msg), "Deseja remover o mentor '%s'?", mentores[selected_mentor].nome);
-                            if (confirmarRemocao(msg)) {
-                                totalMentores = removerMentor(&mentores, totalMentores, selected_mentor);
-                                salvarMentores(mentores, totalMentores);
-                                print_border_top();
-                                print_line("Mentor removido com sucesso.");
-                                print_border_bottom();
-                                esperarPressionarQ();
-                                selecting = 0;
-                            } else {
-                                selecting = 0;
-                            }
-                        }
+                        esperarPressionarQ();
                     }
                     break;
                 }
                 case 5: {
                     // Remover Mentorado
-                    if (totalMentorados == 0) {
+                    if (totalAtivos(&persistencia_mentorados, totalMentorados) == 0) {
                         print_border_top();
                         print_line("Nenhum mentorado cadastrado para remover.");
                         print_border_bottom();
                         esperarPressionarQ();
                         break;
                     }
-                    int selected_mentorado = 0;
-                    int selecting = 1;
-                    while (selecting) {
-                        system("clear");
+                    int ativos = 0;
+                    int *ids = idsAtivos(&persistencia_mentorados, totalMentorados, &ativos);
+                    int selected_mentorado = percorrerLista("Selecione o Mentorado a Remover:", ids, ativos, formatarItemMentorado, textoBuscaMentorado, mentorados, 1);
+                    free(ids);
+                    if (selected_mentorado < 0) break;
+                    char msg[220];
+                    snprintf(msg, sizeof(msg), "Deseja remover o mentorado '%s'?", mentorados[selected_mentorado].nome);
+                    if (confirmarRemocao(msg)) {
+                        totalMentorados = removerMentorado(&mentorados, totalMentorados, selected_mentorado);
                         print_border_top();
-                        print_line("Selecione o Mentorado a Remover:");
-                        print_line("");
-                        for (int i = 0; i < totalMentorados; i++) {
-                            char linha[220];
-                            char buffer[260];
-                            snprintf(linha, sizeof(linha), "%s - Objetivo: %s", mentorados[i].nome, mentorados[i].objetivo);
-                            if (i == selected_mentorado) snprintf(buffer, sizeof(buffer), " < %s >", linha);
-                            else snprintf(buffer, sizeof(buffer), " %s ", linha);
-                            print_line(buffer);
-                        }
-                        print_line("");
-                        print_line("Use as setas ou W/S para navegar. Enter para selecionar.");
+                        print_line("Mentorado removido com sucesso.");
                         print_border_bottom();
-                        int tecla2 = capturaTecla();
-                        if (tecla2 == 'w') selected_mentorado = (selected_mentorado - 1 + totalMentorados) % totalMentorados;
-                        else if (tecla2 == 's') selected_mentorado = (selected_mentorado + 1) % totalMentorados;
-                        else if (tecla2 == '\n') {
-                            char msg[220];
-                            snprintf(msg, sizeof(msg), "Deseja remover o mentorado '%s'?", mentorados[selected_mentorado].nome);
-                            if (confirmarRemocao(msg)) {
-                                totalMentorados = removerMentorado(&mentorados, totalMentorados, selected_mentorado);
-                                salvarMentorados(mentorados, totalMentorados);
-                                print_border_top();
-                                print_line("Mentorado removido com sucesso.");
-                                print_border_bottom();
-                                esperarPressionarQ();
-                                selecting = 0;
-                            } else {
-                                selecting = 0;
-                            }
-                        }
+                        esperarPressionarQ();
                     }
                     break;
                 }
                 case 6: {
                     // Encontrar Mentor Ideal (usa Gemini)
-                    if (totalMentores == 0) {
+                    if (totalAtivos(&persistencia_mentores, totalMentores) == 0) {
                         print_border_top();
                         print_line("Nenhum mentor cadastrado. Impossível sugerir combinacao.");
                         print_border_bottom();
                         esperarPressionarQ();
                         break;
                     }
-                    if (totalMentorados == 0) {
+                    if (totalAtivos(&persistencia_mentorados, totalMentorados) == 0) {
                         print_border_top();
                         print_line("Nenhum mentorado cadastrado. Selecione um mentorado primeiro.");
                         print_border_bottom();
@@ -641,70 +5004,174 @@ int main() {
                         break;
                     }
                     // Seleciona mentorado
-                    int selected_ment = 0;
-                    int selecting = 1;
-                    while (selecting) {
-                        system("clear");
-                        print_border_top();
-                        print_line("Selecione o Mentorado para buscar o Mentor Ideal:");
-                        print_line("");
-                        for (int i = 0; i < totalMentorados; i++) {
-                            char linha[220];
-                            char buffer[260];
-                            snprintf(linha, sizeof(linha), "%s - Objetivo: %s", mentorados[i].nome, mentorados[i].objetivo);
-                            if (i == selected_ment) snprintf(buffer, sizeof(buffer), " < %s >", linha);
-                            else snprintf(buffer, sizeof(buffer), " %s ", linha);
-                            print_line(buffer);
-                        }
-                        print_line("");
-                        print_line("Use as setas ou W/S para navegar. Enter para selecionar.");
-                        print_border_bottom();
-                        int tecla2 = capturaTecla();
-                        if (tecla2 == 'w') selected_ment = (selected_ment - 1 + totalMentorados) % totalMentorados;
-                        else if (tecla2 == 's') selected_ment = (selected_ment + 1) % totalMentorados;
-                        else if (tecla2 == '\n') {
-                            selecting = 0;
-                        }
+                    int ativos = 0;
+                    int *ids = idsAtivos(&persistencia_mentorados, totalMentorados, &ativos);
+                    int selected_ment = percorrerLista("Selecione o Mentorado para buscar o Mentor Ideal:", ids, ativos, formatarItemMentorado, textoBuscaMentorado, mentorados, 1);
+                    free(ids);
+                    if (selected_ment < 0) break;
+
+                    Mentorado *mentorado = &mentorados[selected_ment];
+                    uint64_t entrada = entradaDoMentorado(mentorado, versaoDasEntradas(mentores, totalMentores, &modelo));
+                    // Mesmos dados da última vez: a recomendação guardada ainda vale
+                    if (respostas_estruturadas && mentorado->recomendacao && mentorado->recomendacao->entrada == entrada) {
+                        char *texto = textoDaRecomendacao(mentorado->recomendacao);
+                        mostrarTextoMultiline("Recomendação guardada (dados inalterados).");
+                        if (texto) mostrarTextoMultiline(texto);
+                        free(texto);
+                        esperarPressionarQ();
+                        break;
                     }
 
-                    // Monta prompt para o Gemini
-                    char *base = carregarPromptBase();
-                    // Constrói lista de mentores no prompt
-                    size_t prompt_size = strlen(base) + 1024 + (size_t)totalMentores * 200 + 1024;
-                    char *prompt = malloc(prompt_size);
-                    if (!prompt) {
-                        free(base);
+                    // Pré-ranqueamento local: só os melhores candidatos vão para o modelo
+                    CandidatoMentor candidatos[TOP_K_MENTORES];
+                    int totalCandidatos = 0;
+                    double inicio_montagem = cronometroMs();
+                    char *prompt = montarPromptMentoria(&modelo, mentores, totalMentores, mentorado, candidatos, &totalCandidatos);
+                    if (prompt && respostas_estruturadas) prompt = pedirRespostaEstruturada(prompt);
+                    double montagem_ms = cronometroMs() - inicio_montagem;
+                    CandidatosConsulta *copia = prompt ? copiarCandidatos(mentores, mentorado, candidatos, totalCandidatos, entrada) : NULL;
+                    if (!prompt || !copia) {
                         print_border_top();
                         print_line("Erro ao alocar memoria para prompt.");
                         print_border_bottom();
+                        free(prompt);
                         esperarPressionarQ();
                         break;
                     }
-                    snprintf(prompt, prompt_size, "%s\n\nMentorado: %s\nObjetivo: %s\n\nMentores disponiveis:\n",
-                             base, mentorados[selected_ment].nome, mentorados[selected_ment].objetivo);
-                    for (int i = 0; i < totalMentores; i++) {
-                        char linha[256];
-                        snprintf(linha, sizeof(linha), "%d) %s — Area: %s, XP: %d anos\n", i+1, mentores[i].nome, mentores[i].area, mentores[i].experiencia);
-                        strncat(prompt, linha, prompt_size - strlen(prompt) - 1);
-                    }
-                    strncat(prompt, "\nCom base nisso, indique 1-3 mentores ideais (por numero e nome), explique o porquê da escolha, quais passos iniciais o mentorado deve seguir e sugira uma primeira atividade/prioridade.\n", prompt_size - strlen(prompt) - 1);
 
-                    // Chama Gemini
-                    mostrarTextoMultiline("Consultando o modelo generativo (Gemini) — aguarde...");
-                    char *resposta = chamarGemini(GEMINI_URL, prompt);
-                    if (!resposta) {
-                        mostrarTextoMultiline("Erro: falha ao chamar a API do Gemini ou resposta vazia.\n");
-                    } else {
+                    // Consulta o cache antes de chamar o Gemini
+                    char *resposta = buscarNoCache(&cache, prompt);
+                    if (resposta && respostas_estruturadas) {
+                        // O cache guarda o JSON bruto: ele é validado de novo e guardado no mentorado
+                        RecomendacaoEstruturada *r = lerRecomendacao(resposta, copia);
+                        free(resposta);
+                        resposta = r ? textoDaRecomendacao(r) : NULL;
+                        if (resposta) {
+                            free(mentorado->recomendacao);
+                            mentorado->recomendacao = r;
+                        } else {
+                            free(r);
+                        }
+                    }
+                    if (resposta) {
+                        free(copia);
+                        mostrarTextoMultiline("Resposta recuperada do cache local.");
                         mostrarTextoMultiline(resposta);
                         free(resposta);
+                        free(prompt);
+                        esperarPressionarQ();
+                        break;
+                    }
+                    // A recomendação local é calculada agora, enquanto os candidatos
+                    // ainda valem; ela é exibida se a consulta falhar ou for cancelada
+                    char *alternativa = recomendacaoLocal(mentores, mentorado, candidatos, totalCandidatos);
+                    int id = enfileirarConsulta(&fila_consultas, mentorados, selected_ment, prompt, alternativa, copia, respostas_estruturadas, montagem_ms);
+                    if (id < 0) {
+                        mostrarTextoMultiline("Erro: falha ao chamar a API do Gemini ou resposta vazia.\n");
+                        esperarPressionarQ();
+                        break;
+                    }
+                    acompanharConsulta(&fila_consultas, id);
+                    break;
+                }
+                case 7: {
+                    // Busca Local por Similaridade (sem o modelo)
+                    if (totalAtivos(&persistencia_mentores, totalMentores) == 0 || totalAtivos(&persistencia_mentorados, totalMentorados) == 0) {
+                        print_border_top();
+                        print_line("Cadastre mentores e mentorados antes da busca.");
+                        print_border_bottom();
+                        esperarPressionarQ();
+                        break;
                     }
+                    int ativos = 0;
+                    int *ids = idsAtivos(&persistencia_mentorados, totalMentorados, &ativos);
+                    int selected_ment = percorrerLista("Selecione o Mentorado para a busca local:", ids, ativos, formatarItemMentorado, textoBuscaMentorado, mentorados, 1);
+                    free(ids);
+                    if (selected_ment < 0) break;
 
-                    free(base);
-                    free(prompt);
+                    CandidatoMentor candidatos[TOP_K_MENTORES];
+                    double inicio = cronometroMs();
+                    int encontrados = ranquearPorSimilaridade(mentores, totalMentores, &mentorados[selected_ment], candidatos, TOP_K_MENTORES);
+                    double duracao = cronometroMs() - inicio;
+                    system("clear");
+                    print_border_top();
+                    char linha[300];
+                    snprintf(linha, sizeof(linha), "Mentores mais próximos de %s:", mentorados[selected_ment].nome);
+                    print_line(linha);
+                    print_line("");
+                    for (int c = 0; c < encontrados; c++) {
+                        const Mentor *m = &mentores[candidatos[c].indice];
+                        snprintf(linha, sizeof(linha), "%d) %s - %s, %d anos XP (%.3f)", c + 1, m->nome, m->area, m->experiencia, candidatos[c].pontuacao);
+                        print_line(linha);
+                        if (candidatos[c].motivo[0]) {
+                            snprintf(linha, sizeof(linha), "   Termos em comum: %s", candidatos[c].motivo);
+                            print_line(linha);
+                        }
+                    }
+                    print_line("");
+                    snprintf(linha, sizeof(linha), "%d áreas, %d mentores, %.2f ms (%s)", vetores_areas.linhas,
+                             totalAtivos(&persistencia_mentores, totalMentores), duracao, nome_kernel_produto);
+                    print_line(linha);
+                    print_border_bottom();
                     esperarPressionarQ();
                     break;
                 }
-                case 7: {
+                case 8: {
+                    // Combinar Todos os Mentorados (curl_multi)
+                    if (totalAtivos(&persistencia_mentores, totalMentores) == 0 || totalAtivos(&persistencia_mentorados, totalMentorados) == 0) {
+                        print_border_top();
+                        print_line("Cadastre mentores e mentorados antes da combinação.");
+                        print_border_bottom();
+                        esperarPressionarQ();
+                        break;
+                    }
+                    print_border_top();
+                    print_line("Combinação em Lote");
+                    print_border_bottom();
+                    char entrada[16];
+                    int concorrencia = CONCORRENCIA_PADRAO;
+                    printf("Requisições simultâneas (1-%d) [%d]: ", CONCORRENCIA_MAXIMA, CONCORRENCIA_PADRAO);
+                    if (lerLinha(entrada, sizeof(entrada)) && atoi(entrada) > 0) concorrencia = atoi(entrada);
+                    if (concorrencia > CONCORRENCIA_MAXIMA) concorrencia = CONCORRENCIA_MAXIMA;
+                    int por_requisicao = MENTORADOS_POR_REQUISICAO;
+                    printf("Mentorados por requisição (1-%d) [%d]: ", MAX_MENTORADOS_POR_REQUISICAO, MENTORADOS_POR_REQUISICAO);
+                    if (lerLinha(entrada, sizeof(entrada)) && atoi(entrada) > 0) por_requisicao = atoi(entrada);
+                    if (por_requisicao > MAX_MENTORADOS_POR_REQUISICAO) por_requisicao = MAX_MENTORADOS_POR_REQUISICAO;
+                    combinarTodosMentorados(&cliente, &cache, &modelo, mentores, totalMentores, mentorados, totalMentorados, concorrencia,
+                                            por_requisicao, NULL);
+                    mostrarTextoMultiline("Combinação concluída. Resultados salvos em " ARQ_RELATORIO ".");
+                    esperarPressionarQ();
+                    break;
+                }
+                case 9: {
+                    // Atribuição Global com Vagas (fluxo de custo mínimo, sem o modelo)
+                    if (totalAtivos(&persistencia_mentores, totalMentores) == 0 || totalAtivos(&persistencia_mentorados, totalMentorados) == 0) {
+                        print_border_top();
+                        print_line("Cadastre mentores e mentorados antes da atribuição.");
+                        print_border_bottom();
+                        esperarPressionarQ();
+                        break;
+                    }
+                    telaAtribuicaoGlobal(&cliente, &cache, &modelo, mentores, totalMentores, mentorados, totalMentorados);
+                    break;
+                }
+                case 10: {
+                    // Consultas ao Modelo (em andamento e concluídas nesta sessão)
+                    listarConsultas(&fila_consultas);
+                    break;
+                }
+                case 11: {
+                    // Histórico de Recomendações (resultados_mentoria.log)
+                    telaHistorico(mentores, totalMentores, &modelo, mentorados, totalMentorados);
+                    break;
+                }
+                case 12: {
+                    // Métricas do Modelo (p50/p95/p99 de metricas_gemini.log)
+                    mostrarResumoMetricas();
+                    esperarPressionarQ();
+                    break;
+                }
+                case 13: {
                     // Sair
                     running = 0;
                     break;
@@ -715,12 +5182,21 @@ int main() {
         }
     }
 
-    // Antes de sair, salva (caso tenha sido alterado) e libera memoria
-    if (totalMentores > 0) salvarMentores(mentores, totalMentores);
-    if (totalMentorados > 0) salvarMentorados(mentorados, totalMentorados);
+    // As alterações já estão no log; só espera uma compactação em andamento
+    encerrarPersistencia(&persistencia_mentores);
+    encerrarPersistencia(&persistencia_mentorados);
     free(mentores);
+    for (int i = 0; i < totalMentorados; i++) free(mentorados[i].recomendacao);
     free(mentorados);
+    liberarIndiceAreas();
 
+    // Consultas ainda pendentes são canceladas
+    encerrarFilaConsultas(&fila_consultas);
+    encerrarMetricas();
+    fecharHistorico(&historico_resultados);
+    fecharCache(&cache);
+    liberarModeloPrompt(&modelo);
+    encerrarClienteGemini(&cliente);
     curl_global_cleanup();
     return 0;
 }
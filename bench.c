@@ -0,0 +1,478 @@
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+
+// Benchmark comparativo dos dois motores do sistema de cursos.
+// O mesmo arquivo é compilado uma vez para cada motor:
+//
+//   gcc -O2 -DMOTOR_PROMPT bench.c -o bench_prompt
+//   gcc -O2 -DMOTOR_PROMPT -DPERFIL_ESTATICO bench.c -o bench_estatico
+//   gcc -O2 -DMOTOR_MAIN bench.c -o bench_main
+//
+// e executado com a mesma carga:
+//   ./bench_xxx [cursos] [alunos] [inscricoes] [buscas] [rodadas de ordenação]
+
+// CONTAGEM DE ALOCAÇÕES
+
+typedef struct {
+    long alocacoes;
+    long liberacoes;
+    size_t bytes_vivos;
+    size_t pico_bytes;
+} ContadorHeap;
+
+static ContadorHeap heap = {0, 0, 0, 0};
+
+// Cada bloco guarda o próprio tamanho num cabeçalho para permitir medir o pico
+#define CABECALHO_HEAP 16
+
+void* bench_malloc(size_t n) {
+    unsigned char* p = malloc(n + CABECALHO_HEAP);
+    if (!p) return NULL;
+    memcpy(p, &n, sizeof(n));
+    heap.alocacoes++;
+    heap.bytes_vivos += n;
+    if (heap.bytes_vivos > heap.pico_bytes) heap.pico_bytes = heap.bytes_vivos;
+    return p + CABECALHO_HEAP;
+}
+
+void* bench_calloc(size_t n, size_t tamanho) {
+    void* p = bench_malloc(n * tamanho);
+    if (p) memset(p, 0, n * tamanho);
+    return p;
+}
+
+void bench_free(void* ptr) {
+    if (!ptr) return;
+    unsigned char* p = (unsigned char*)ptr - CABECALHO_HEAP;
+    size_t n;
+    memcpy(&n, p, sizeof(n));
+    heap.liberacoes++;
+    heap.bytes_vivos -= n;
+    free(p);
+}
+
+void* bench_realloc(void* ptr, size_t n) {
+    if (!ptr) return bench_malloc(n);
+    unsigned char* p = (unsigned char*)ptr - CABECALHO_HEAP;
+    size_t antigo;
+    memcpy(&antigo, p, sizeof(antigo));
+    unsigned char* novo = realloc(p, n + CABECALHO_HEAP);
+    if (!novo) return NULL;
+    memcpy(novo, &n, sizeof(n));
+    heap.alocacoes++;
+    heap.bytes_vivos = heap.bytes_vivos - antigo + n;
+    if (heap.bytes_vivos > heap.pico_bytes) heap.pico_bytes = heap.bytes_vivos;
+    return novo + CABECALHO_HEAP;
+}
+
+// INCLUSÃO DO MOTOR
+
+#define malloc(n) bench_malloc(n)
+#define calloc(n, t) bench_calloc(n, t)
+#define realloc(p, n) bench_realloc(p, n)
+#define free(p) bench_free(p)
+#define main main_motor
+// Mensagens do motor não entram na medição
+#define printf(...) ((void)(0 && printf(__VA_ARGS__)))
+
+#if defined(MOTOR_PROMPT)
+#include "prompt.c"
+#define NOME_MOTOR "prompt.c (arrays estáticos)"
+#elif defined(MOTOR_MAIN)
+#include "main.c"
+#define NOME_MOTOR "main.c (realloc +10)"
+#else
+#error "Defina MOTOR_PROMPT ou MOTOR_MAIN"
+#endif
+
+#undef printf
+#undef main
+#undef free
+#undef realloc
+#undef calloc
+#undef malloc
+
+#ifdef PERFIL_ESTATICO
+#define PERFIL_MOTOR "estático"
+#else
+#define PERFIL_MOTOR "dinâmico"
+#endif
+
+// ADAPTADORES (únicas diferenças de API entre os motores)
+
+#ifdef MOTOR_PROMPT
+static int limiteCursos(void) { return MAX_CURSOS; }
+static int limiteAlunos(void) { return MAX_ALUNOS; }
+
+static int motorAdicionarCurso(const Curso* c) {
+    if (num_cursos >= MAX_CURSOS) return 0;
+    cursos[num_cursos++] = *c;
+    return 1;
+}
+
+static int motorAdicionarAluno(const Aluno* a) {
+    if (num_alunos >= MAX_ALUNOS) return 0;
+    alunos[num_alunos++] = *a;
+    return 1;
+}
+
+static int motorEnfileirar(Fila* f, Inscricao i) {
+    return enfileirar(f, i);
+}
+
+static int motorDesempilhar(Pilha* p) {
+    char acao[MAX_ACAO];
+    return desempilhar(p, acao);
+}
+
+static void motorAposOrdenar(void) {
+}
+
+static void motorLiberarDados(void) {
+    num_cursos = 0;
+    num_alunos = 0;
+}
+#else
+static int limiteCursos(void) { return INT32_MAX; }
+static int limiteAlunos(void) { return INT32_MAX; }
+
+static int motorAdicionarCurso(const Curso* c) {
+    if (num_cursos >= capacidade_cursos) expandirCursos();
+    cursos[num_cursos++] = *c;
+    indexarCurso(num_cursos - 1);
+    return 1;
+}
+
+static int motorAdicionarAluno(const Aluno* a) {
+    if (num_alunos >= capacidade_alunos) expandirAlunos();
+    alunos[num_alunos++] = *a;
+    return 1;
+}
+
+static int motorEnfileirar(Fila* f, Inscricao i) {
+    int antes = f->tamanho;
+    enfileirar(f, i);
+    return f->tamanho > antes;
+}
+
+static int motorDesempilhar(Pilha* p) {
+    char* acao = desempilhar(p);
+    if (!acao) return 0;
+    bench_free(acao);
+    return 1;
+}
+
+static void motorAposOrdenar(void) {
+    reconstruirIndiceCursos();
+}
+
+static void motorLiberarDados(void) {
+    liberarIndiceCursos();
+    bench_free(cursos);
+    bench_free(alunos);
+    cursos = NULL;
+    alunos = NULL;
+    num_cursos = num_alunos = 0;
+    capacidade_cursos = capacidade_alunos = 0;
+}
+#endif
+
+// MEDIÇÃO
+
+typedef struct {
+    const char* nome;
+    uint64_t* amostras; // latência de cada operação em ns
+    long total;
+    long capacidade;
+    uint64_t inicio_ns;
+    uint64_t duracao_ns;
+    long alocacoes;
+    long liberacoes;
+} Fase;
+
+static uint64_t agoraNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t estado_rng = 0x9E3779B97F4A7C15ull;
+
+static uint64_t proximoAleatorio(void) {
+    estado_rng ^= estado_rng << 13;
+    estado_rng ^= estado_rng >> 7;
+    estado_rng ^= estado_rng << 17;
+    return estado_rng;
+}
+
+static void iniciarFase(Fase* f, const char* nome, long capacidade) {
+    f->nome = nome;
+    f->total = 0;
+    f->capacidade = capacidade > 0 ? capacidade : 1;
+    f->amostras = malloc(sizeof(uint64_t) * f->capacidade);
+    if (!f->amostras) {
+        fprintf(stderr, "Erro: Falha na alocação das amostras.\n");
+        exit(1);
+    }
+    f->alocacoes = heap.alocacoes;
+    f->liberacoes = heap.liberacoes;
+    f->inicio_ns = agoraNs();
+}
+
+static void registrar(Fase* f, uint64_t ns) {
+    if (f->total < f->capacidade) f->amostras[f->total++] = ns;
+}
+
+static void encerrarFase(Fase* f) {
+    f->duracao_ns = agoraNs() - f->inicio_ns;
+    f->alocacoes = heap.alocacoes - f->alocacoes;
+    f->liberacoes = heap.liberacoes - f->liberacoes;
+}
+
+static int compararU64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentil(const Fase* f, double p) {
+    if (f->total == 0) return 0;
+    long i = (long)(p * (f->total - 1));
+    return f->amostras[i];
+}
+
+static void imprimirFase(Fase* f) {
+    qsort(f->amostras, f->total, sizeof(uint64_t), compararU64);
+    double segundos = f->duracao_ns / 1e9;
+    double vazao = segundos > 0 ? f->total / segundos : 0;
+    printf("%-12s %10ld %14.0f %10llu %10llu %10llu %10ld %10ld\n",
+           f->nome, f->total, vazao,
+           (unsigned long long)percentil(f, 0.50),
+           (unsigned long long)percentil(f, 0.95),
+           (unsigned long long)percentil(f, 0.99),
+           f->alocacoes, f->liberacoes);
+    free(f->amostras);
+    f->amostras = NULL;
+}
+
+// CARGA DE TRABALHO
+
+int main(int argc, char* argv[]) {
+    long n_cursos = argc > 1 ? atol(argv[1]) : 1000;
+    long n_alunos = argc > 2 ? atol(argv[2]) : 1000;
+    long n_inscricoes = argc > 3 ? atol(argv[3]) : 10000;
+    long n_buscas = argc > 4 ? atol(argv[4]) : 100000;
+    int rodadas_ordenacao = argc > 5 ? atoi(argv[5]) : 20;
+
+    if (n_cursos < 1 || n_alunos < 1 || n_inscricoes < 0 || n_buscas < 0 || rodadas_ordenacao < 0) {
+        fprintf(stderr, "Uso: %s [cursos] [alunos] [inscricoes] [buscas] [rodadas de ordenação]\n", argv[0]);
+        return 1;
+    }
+    if (n_cursos > limiteCursos() || n_alunos > limiteAlunos()) {
+        fprintf(stderr, "Aviso: carga excede os limites do motor (%d cursos, %d alunos).\n",
+                limiteCursos(), limiteAlunos());
+    }
+
+#ifdef PERFIL_ESTATICO
+    static Fila fila;
+    static Pilha historico;
+#else
+    Fila fila;
+    Pilha historico;
+#endif
+    inicializarFila(&fila);
+    inicializarPilha(&historico);
+
+    printf("Motor: %s, perfil %s\n", NOME_MOTOR, PERFIL_MOTOR);
+    printf("Carga: %ld cursos, %ld alunos, %ld inscrições, %ld buscas\n\n",
+           n_cursos, n_alunos, n_inscricoes, n_buscas);
+    printf("%-12s %10s %14s %10s %10s %10s %10s %10s\n",
+           "fase", "ops", "ops/s", "p50 ns", "p95 ns", "p99 ns", "allocs", "frees");
+
+    Fase fase;
+    long recusadas = 0;
+
+    iniciarFase(&fase, "add-curso", n_cursos);
+    for (long i = 0; i < n_cursos; i++) {
+        Curso c;
+        memset(&c, 0, sizeof(c));
+        snprintf(c.nome, MAX_NOME, "Curso %ld", i);
+        c.duracao = 20 + (int)(proximoAleatorio() % 200);
+        c.prioridade = 1 + (int)(proximoAleatorio() % 10);
+#ifdef MOTOR_MAIN
+        c.vagas = 10 + (int)(proximoAleatorio() % 190);
+#endif
+        uint64_t t0 = agoraNs();
+        if (!motorAdicionarCurso(&c)) recusadas++;
+        registrar(&fase, agoraNs() - t0);
+    }
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+
+    iniciarFase(&fase, "add-aluno", n_alunos);
+    for (long i = 0; i < n_alunos; i++) {
+        Aluno a;
+        snprintf(a.nome, MAX_NOME, "Aluno %ld", i);
+        a.id = (int)i;
+        uint64_t t0 = agoraNs();
+        if (!motorAdicionarAluno(&a)) recusadas++;
+        registrar(&fase, agoraNs() - t0);
+    }
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+
+    // Inscrição idêntica à do menu: busca do aluno por id e do curso por nome
+    iniciarFase(&fase, "inscricao", n_inscricoes);
+    for (long i = 0; i < n_inscricoes; i++) {
+        int id = (int)(proximoAleatorio() % n_alunos);
+        char nome_curso[MAX_NOME];
+        snprintf(nome_curso, sizeof(nome_curso), "Curso %ld", (long)(proximoAleatorio() % n_cursos));
+        uint64_t t0 = agoraNs();
+        int aluno_index = buscaLinearAluno(alunos, num_alunos, id);
+        int index_curso;
+        for (index_curso = 0; index_curso < num_cursos; index_curso++) {
+            if (strcmp(cursos[index_curso].nome, nome_curso) == 0) break;
+        }
+        if (aluno_index == -1 || index_curso == num_cursos) {
+            recusadas++;
+        } else {
+            Inscricao nova;
+            memset(&nova, 0, sizeof(nova));
+            nova.aluno = alunos[aluno_index];
+            nova.curso_index = index_curso;
+            nova.timestamp = time(NULL);
+            if (motorEnfileirar(&fila, nova)) {
+                char acao[100];
+                snprintf(acao, sizeof(acao), "Inscrição: %s", nova.aluno.nome);
+                empilhar(&historico, acao);
+            } else {
+                recusadas++;
+            }
+        }
+        registrar(&fase, agoraNs() - t0);
+    }
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+
+#ifdef MOTOR_MAIN
+    // Alocação em lote das mesmas inscrições, antes do processamento unitário
+    Fila copia;
+    inicializarFila(&copia);
+    for (NoFila* no = fila.frente; no; no = no->proximo) {
+        Inscricao inscricao = no->inscricao;
+        inscricao.prioridade = 1 + (int)(proximoAleatorio() % PRIORIDADES_INSCRICAO);
+        enfileirar(&copia, inscricao);
+    }
+    long pedidos = copia.tamanho, em_espera = 0;
+    iniciarFase(&fase, "aloca-lote", 1);
+    uint64_t t_lote = agoraNs();
+    long matriculados = alocarInscricoesEmLote(&copia, &em_espera);
+    registrar(&fase, agoraNs() - t_lote);
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+    printf("  %ld pedidos: %ld matrículas, %ld em espera\n", pedidos, matriculados, em_espera);
+    for (int i = 0; i < num_cursos; i++) cursos[i].ocupadas = cursos[i].em_espera = 0;
+    while (!filaVazia(&lista_espera)) desenfileirar(&lista_espera);
+#endif
+
+    iniciarFase(&fase, "processa", fila.tamanho);
+    while (!filaVazia(&fila)) {
+        uint64_t t0 = agoraNs();
+        Inscricao processada = desenfileirar(&fila);
+        char acao[100];
+        snprintf(acao, sizeof(acao), "Processamento: %s", processada.aluno.nome);
+        empilhar(&historico, acao);
+        registrar(&fase, agoraNs() - t0);
+    }
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+
+    // Cada rodada reordena a mesma permutação inicial dos cursos
+    Curso* original = malloc(sizeof(Curso) * (num_cursos > 0 ? num_cursos : 1));
+    if (!original) {
+        fprintf(stderr, "Erro: Falha na alocação da cópia dos cursos.\n");
+        return 1;
+    }
+    memcpy(original, cursos, sizeof(Curso) * num_cursos);
+    iniciarFase(&fase, "ordenacao", rodadas_ordenacao);
+    for (int r = 0; r < rodadas_ordenacao; r++) {
+        memcpy(cursos, original, sizeof(Curso) * num_cursos);
+        uint64_t t0 = agoraNs();
+        if (num_cursos > 0) quickSort(cursos, 0, num_cursos - 1);
+        registrar(&fase, agoraNs() - t0);
+    }
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+    free(original);
+    motorAposOrdenar();
+
+    iniciarFase(&fase, "busca-curso", n_buscas);
+    long encontrados = 0;
+    for (long i = 0; i < n_buscas; i++) {
+        int prioridade = 1 + (int)(proximoAleatorio() % 10);
+        uint64_t t0 = agoraNs();
+        if (buscaBinariaCurso(cursos, num_cursos, prioridade) != -1) encontrados++;
+        registrar(&fase, agoraNs() - t0);
+    }
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+
+    iniciarFase(&fase, "busca-aluno", n_buscas);
+    for (long i = 0; i < n_buscas; i++) {
+        int id = (int)(proximoAleatorio() % n_alunos);
+        uint64_t t0 = agoraNs();
+        if (buscaLinearAluno(alunos, num_alunos, id) != -1) encontrados++;
+        registrar(&fase, agoraNs() - t0);
+    }
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+
+#ifdef MOTOR_MAIN
+    // Busca por trecho do nome (índice de trigramas, só existe em main.c)
+    iniciarFase(&fase, "busca-nome", n_buscas);
+    for (long i = 0; i < n_buscas; i++) {
+        const char* nome = cursos[proximoAleatorio() % num_cursos].nome;
+        int len = (int)strlen(nome);
+        int inicio = (int)(proximoAleatorio() % (len > 3 ? len - 3 : 1));
+        int tamanho = 3 + (int)(proximoAleatorio() % 6);
+        char consulta[MAX_NOME];
+        snprintf(consulta, sizeof(consulta), "%.*s", tamanho, nome + inicio);
+        ResultadoBusca res[MAX_RESULTADOS_BUSCA];
+        uint64_t t0 = agoraNs();
+        if (buscarCursosPorNome(consulta, res, MAX_RESULTADOS_BUSCA) > 0) encontrados++;
+        registrar(&fase, agoraNs() - t0);
+    }
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+#endif
+
+    iniciarFase(&fase, "undo", historico.tamanho);
+    while (!pilhaVazia(&historico)) {
+        uint64_t t0 = agoraNs();
+        motorDesempilhar(&historico);
+        registrar(&fase, agoraNs() - t0);
+    }
+    encerrarFase(&fase);
+    imprimirFase(&fase);
+
+    size_t pico_heap = heap.pico_bytes;
+    motorLiberarDados();
+
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    printf("\nOperações recusadas: %ld, buscas com sucesso: %ld\n", recusadas, encontrados);
+#ifdef MOTOR_PROMPT
+    // Em main.c os dados ficam no heap (já contados no pico abaixo); aqui
+    // 'cursos' e 'alunos' são os próprios arrays
+    printf("Memória estática do motor: %zu bytes\n",
+           sizeof(cursos) + sizeof(alunos) + sizeof(fila) + sizeof(historico));
+#endif
+    printf("Pico de heap do motor: %zu bytes (%ld allocs, %ld frees, %zu bytes vazados)\n",
+           pico_heap, heap.alocacoes, heap.liberacoes, heap.bytes_vivos);
+    printf("RSS máximo do processo: %ld KiB\n", uso.ru_maxrss);
+    return 0;
+}
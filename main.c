@@ -2,21 +2,35 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <ctype.h>
 #include <time.h>
 #include <wchar.h>
 #include <locale.h>
 #include <termios.h>
 #include <unistd.h>
+#include <poll.h>
 
 // Definições de constantes para otimização
 #define MAX_NOME 50
 #define INCREMENTO_CAPACIDADE 10 
 #define WIDTH 60
+#define FATIA_PROCESSAMENTO_US 5000 // tempo máximo de processamento entre leituras do teclado
+#define INTERVALO_STATUS_MS 500     // frequência máxima de redesenho do menu pelo processamento
+#define TECLA_ATUALIZAR 0           // retornada por capturaTecla quando só o status mudou
+#define MARCA_INICIO 1              // byte que ancora os trigramas no início do nome
+#define MAX_RESULTADOS_BUSCA 10
+#define PRIORIDADES_INSCRICAO 10    // prioridades de inscrição vão de 1 a 10
+#define LIMITE_CANDIDATOS_BUSCA 10000     // candidatos verificados por consulta (mantém a busca abaixo de 1 ms)
+#define LIMITE_POSTAGENS_APROXIMADA 10000 // ids percorridos pela busca aproximada
 
 typedef struct {
     char nome[MAX_NOME];
     int duracao;
     int prioridade;
+    int vagas;     // 0 = sem limite
+    int ocupadas;
+    int em_espera;
 } Curso;
 
 typedef struct {
@@ -27,9 +41,22 @@ typedef struct {
 typedef struct {
     Aluno aluno;
     int curso_index;
+    int prioridade; // 1-10, maior prioridade recebe vaga primeiro
     time_t timestamp;
 } Inscricao;
 
+typedef struct {
+    uint32_t chave; // trigrama empacotado; 0 indica posição vazia
+    int* ids;       // índices de cursos em ordem crescente
+    int total;
+    int capacidade;
+} Postagem;
+
+typedef struct {
+    int id;
+    long pontuacao;
+} ResultadoBusca;
+
 typedef struct NoFila {
     Inscricao inscricao;
     struct NoFila* proximo;
@@ -39,6 +66,7 @@ typedef struct {
     NoFila* frente;
     NoFila* tras;
     int tamanho;
+    int desordenada; // chegou inscrição de prioridade maior que a do fim da fila
 } Fila;
 
 typedef struct NoPilha {
@@ -51,6 +79,9 @@ typedef struct {
     int tamanho;
 } Pilha;
 
+// Inscrições que encontraram o curso lotado, na ordem em que foram recusadas
+Fila lista_espera = { NULL, NULL, 0, 0 };
+
 Curso* cursos = NULL;
 int num_cursos = 0;
 int capacidade_cursos = 0;
@@ -59,6 +90,24 @@ Aluno* alunos = NULL;
 int num_alunos = 0;
 int capacidade_alunos = 0;
 
+long inscricoes_processadas_fundo = 0;
+
+// Índice de trigramas dos nomes dos cursos (tabela hash com endereçamento aberto)
+Postagem* indice_trigramas = NULL;
+int capacidade_indice = 0;
+int ocupacao_indice = 0;
+
+// Nome exato -> índice do curso (endereçamento aberto; -1 indica posição vazia)
+int* indice_nomes = NULL;
+int capacidade_nomes = 0;
+int ocupacao_nomes = 0;
+
+// Contadores da busca aproximada; a época evita zerar o array a cada consulta
+int* contagem_busca = NULL;
+unsigned* epoca_busca = NULL;
+unsigned epoca_atual = 0;
+int capacidade_busca = 0;
+
 int visual_width(const char *s) {
     int width = 0;
     wchar_t wc;
@@ -102,25 +151,6 @@ void limparBufferEntrada() {
     while ((c = getchar()) != '\n' && c != EOF);
 }
 
-int capturaTecla() {
-    struct termios oldt, newt;
-    int ch;
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    ch = getchar();
-    if (ch == 27) {
-        getchar();
-        ch = getchar();
-        if (ch == 'A') ch = 'w';
-        else if (ch == 'B') ch = 's';
-        else ch = 0;
-    }
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    return ch;
-}
-
 void esperarPressionarQ() {
     char input[10];
     print_border_top();
@@ -138,6 +168,7 @@ void inicializarFila(Fila* f) {
     f->frente = NULL;
     f->tras = NULL;
     f->tamanho = 0;
+    f->desordenada = 0;
 }
 
 int filaVazia(Fila* f) {
@@ -155,6 +186,7 @@ void enfileirar(Fila* f, Inscricao inscricao) {
     if (filaVazia(f)) {
         f->frente = f->tras = novo;
     } else {
+        if (inscricao.prioridade > f->tras->inscricao.prioridade) f->desordenada = 1;
         f->tras->proximo = novo;
         f->tras = novo;
     }
@@ -273,6 +305,298 @@ void expandirAlunos() {
     }
 }
 
+// Índice de trigramas: cada nome é indexado em minúsculas (ASCII) junto com
+// dois trigramas ancorados no início ("\1\1a", "\1ab"), que atendem consultas
+// de prefixo com 1 ou 2 caracteres. As listas de ids ficam em ordem crescente.
+unsigned char minusculo(unsigned char c) {
+    return c < 128 ? (unsigned char)tolower(c) : c;
+}
+
+uint32_t chaveTrigrama(const unsigned char* t) {
+    return ((uint32_t)t[0] << 16) | ((uint32_t)t[1] << 8) | t[2];
+}
+
+uint32_t hashTrigrama(uint32_t chave) {
+    return chave * 2654435761u;
+}
+
+Postagem* localizarPostagem(uint32_t chave) {
+    if (capacidade_indice == 0) return NULL;
+    uint32_t mascara = (uint32_t)capacidade_indice - 1;
+    for (uint32_t i = hashTrigrama(chave) & mascara; ; i = (i + 1) & mascara) {
+        if (indice_trigramas[i].chave == chave) return &indice_trigramas[i];
+        if (indice_trigramas[i].chave == 0) return NULL;
+    }
+}
+
+void expandirIndice() {
+    int nova_capacidade = capacidade_indice ? capacidade_indice * 2 : 1024;
+    Postagem* nova = (Postagem*)calloc(nova_capacidade, sizeof(Postagem));
+    if (!nova) {
+        printf("Erro: Falha na alocação do índice de cursos.\n");
+        exit(1);
+    }
+    uint32_t mascara = (uint32_t)nova_capacidade - 1;
+    for (int i = 0; i < capacidade_indice; i++) {
+        if (indice_trigramas[i].chave == 0) continue;
+        uint32_t j = hashTrigrama(indice_trigramas[i].chave) & mascara;
+        while (nova[j].chave != 0) j = (j + 1) & mascara;
+        nova[j] = indice_trigramas[i];
+    }
+    free(indice_trigramas);
+    indice_trigramas = nova;
+    capacidade_indice = nova_capacidade;
+}
+
+void adicionarPostagem(uint32_t chave, int id) {
+    if ((ocupacao_indice + 1) * 2 > capacidade_indice) expandirIndice();
+    uint32_t mascara = (uint32_t)capacidade_indice - 1;
+    uint32_t i = hashTrigrama(chave) & mascara;
+    while (indice_trigramas[i].chave != 0 && indice_trigramas[i].chave != chave) i = (i + 1) & mascara;
+    Postagem* p = &indice_trigramas[i];
+    if (p->chave == 0) {
+        p->chave = chave;
+        ocupacao_indice++;
+    }
+    // Trigramas repetidos no mesmo nome entram uma única vez
+    if (p->total > 0 && p->ids[p->total - 1] == id) return;
+    if (p->total >= p->capacidade) {
+        int nova_capacidade = p->capacidade ? p->capacidade * 2 : 4;
+        int* ids = (int*)realloc(p->ids, nova_capacidade * sizeof(int));
+        if (!ids) {
+            printf("Erro: Falha na realocação do índice de cursos.\n");
+            exit(1);
+        }
+        p->ids = ids;
+        p->capacidade = nova_capacidade;
+    }
+    p->ids[p->total++] = id;
+}
+
+uint32_t hashNome(const char* nome) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char* c = (const unsigned char*)nome; *c; c++) h = (h ^ *c) * 16777619u;
+    return h;
+}
+
+// Posição do nome na tabela: a do curso com esse nome ou a vazia onde ele entraria
+uint32_t posicaoNome(const char* nome) {
+    uint32_t mascara = (uint32_t)capacidade_nomes - 1;
+    uint32_t i = hashNome(nome) & mascara;
+    while (indice_nomes[i] != -1 && strcmp(cursos[indice_nomes[i]].nome, nome) != 0) i = (i + 1) & mascara;
+    return i;
+}
+
+void expandirIndiceNomes() {
+    int* antigo = indice_nomes;
+    int capacidade_antiga = capacidade_nomes;
+    capacidade_nomes = capacidade_nomes ? capacidade_nomes * 2 : 1024;
+    indice_nomes = (int*)malloc(capacidade_nomes * sizeof(int));
+    if (!indice_nomes) {
+        printf("Erro: Falha na alocação do índice de nomes.\n");
+        exit(1);
+    }
+    memset(indice_nomes, 0xFF, capacidade_nomes * sizeof(int));
+    for (int i = 0; i < capacidade_antiga; i++) {
+        if (antigo[i] != -1) indice_nomes[posicaoNome(cursos[antigo[i]].nome)] = antigo[i];
+    }
+    free(antigo);
+}
+
+// Com nomes repetidos, vale o primeiro curso (como na busca linear)
+void indexarNomeCurso(int id) {
+    if ((ocupacao_nomes + 1) * 2 > capacidade_nomes) expandirIndiceNomes();
+    uint32_t i = posicaoNome(cursos[id].nome);
+    if (indice_nomes[i] != -1) return;
+    indice_nomes[i] = id;
+    ocupacao_nomes++;
+}
+
+// Curso com exatamente este nome, sem limite de candidatos; -1 se não existir
+int buscarCursoExato(const char* nome) {
+    if (capacidade_nomes == 0) return -1;
+    return indice_nomes[posicaoNome(nome)];
+}
+
+void indexarCurso(int id) {
+    indexarNomeCurso(id);
+    unsigned char buf[MAX_NOME + 2];
+    int len = 2;
+    buf[0] = buf[1] = MARCA_INICIO;
+    for (const char* c = cursos[id].nome; *c && len < MAX_NOME + 1; c++) buf[len++] = minusculo((unsigned char)*c);
+    for (int i = 0; i + 3 <= len; i++) adicionarPostagem(chaveTrigrama(buf + i), id);
+}
+
+// Necessário quando os índices dos cursos mudam (ex.: após a ordenação)
+void reconstruirIndiceCursos() {
+    for (int i = 0; i < capacidade_indice; i++) indice_trigramas[i].total = 0;
+    if (indice_nomes) memset(indice_nomes, 0xFF, capacidade_nomes * sizeof(int));
+    ocupacao_nomes = 0;
+    for (int i = 0; i < num_cursos; i++) indexarCurso(i);
+}
+
+void liberarIndiceCursos() {
+    for (int i = 0; i < capacidade_indice; i++) free(indice_trigramas[i].ids);
+    free(indice_trigramas);
+    indice_trigramas = NULL;
+    capacidade_indice = ocupacao_indice = 0;
+    free(indice_nomes);
+    indice_nomes = NULL;
+    capacidade_nomes = ocupacao_nomes = 0;
+    free(contagem_busca);
+    free(epoca_busca);
+    contagem_busca = NULL;
+    epoca_busca = NULL;
+    capacidade_busca = 0;
+}
+
+// Posição de 'consulta' (já em minúsculas) dentro de 'nome', ignorando caixa; -1 se ausente
+int posicaoSemCaixa(const char* nome, const char* consulta, int qlen) {
+    for (int i = 0; nome[i]; i++) {
+        int j = 0;
+        while (j < qlen && nome[i + j] && minusculo((unsigned char)nome[i + j]) == (unsigned char)consulta[j]) j++;
+        if (j == qlen) return i;
+    }
+    return -1;
+}
+
+// Mantém os 'max' melhores resultados em ordem decrescente de pontuação
+void inserirResultado(ResultadoBusca* res, int* n, int max, int id, long pontuacao) {
+    if (*n == max && res[max - 1].pontuacao >= pontuacao) return;
+    int i = (*n < max) ? (*n)++ : max - 1;
+    while (i > 0 && res[i - 1].pontuacao < pontuacao) {
+        res[i] = res[i - 1];
+        i--;
+    }
+    res[i].id = id;
+    res[i].pontuacao = pontuacao;
+}
+
+void garantirContadoresBusca() {
+    if (capacidade_busca >= num_cursos) return;
+    int nova_capacidade = capacidade_cursos;
+    int* contagem = (int*)realloc(contagem_busca, nova_capacidade * sizeof(int));
+    unsigned* epoca = (unsigned*)realloc(epoca_busca, nova_capacidade * sizeof(unsigned));
+    if (!contagem || !epoca) {
+        printf("Erro: Falha na realocação dos contadores de busca.\n");
+        exit(1);
+    }
+    memset(epoca + capacidade_busca, 0, (nova_capacidade - capacidade_busca) * sizeof(unsigned));
+    contagem_busca = contagem;
+    epoca_busca = epoca;
+    capacidade_busca = nova_capacidade;
+}
+
+// Busca por prefixo e trecho do nome com ranqueamento. Correspondências exatas
+// vêm primeiro (prefixo > início de palavra > meio do nome, nomes mais curtos e
+// de maior prioridade antes); se sobrar espaço, completa com nomes que
+// compartilham ao menos metade dos trigramas da consulta (tolerante a erros).
+// Consultas muito genéricas avaliam só os primeiros LIMITE_CANDIDATOS_BUSCA
+// candidatos; continuar digitando refina o resultado.
+int buscarCursosPorNome(const char* consulta, ResultadoBusca* res, int max) {
+    char q[MAX_NOME];
+    int qlen = 0;
+    for (; consulta[qlen] && qlen < MAX_NOME - 1; qlen++) q[qlen] = (char)minusculo((unsigned char)consulta[qlen]);
+    q[qlen] = '\0';
+    if (qlen == 0 || max <= 0) return 0;
+
+    // Consultas curtas usam os trigramas ancorados (só prefixo)
+    uint32_t chaves[MAX_NOME];
+    int nchaves = 0;
+    if (qlen < 3) {
+        unsigned char t[3] = { MARCA_INICIO, MARCA_INICIO, (unsigned char)q[0] };
+        if (qlen == 2) {
+            t[1] = (unsigned char)q[0];
+            t[2] = (unsigned char)q[1];
+        }
+        chaves[nchaves++] = chaveTrigrama(t);
+    } else {
+        for (int i = 0; i + 3 <= qlen; i++) {
+            uint32_t chave = chaveTrigrama((const unsigned char*)q + i);
+            int repetida = 0;
+            for (int j = 0; j < nchaves; j++) if (chaves[j] == chave) repetida = 1;
+            if (!repetida) chaves[nchaves++] = chave;
+        }
+    }
+
+    Postagem* listas[MAX_NOME];
+    int nlistas = 0;
+    int todas_presentes = 1;
+    for (int i = 0; i < nchaves; i++) {
+        Postagem* p = localizarPostagem(chaves[i]);
+        if (p && p->total > 0) listas[nlistas++] = p;
+        else todas_presentes = 0;
+    }
+
+    int n = 0;
+    if (todas_presentes && nlistas > 0) {
+        // Só a menor lista é percorrida; o trecho contíguo é confirmado no nome
+        Postagem* base = listas[0];
+        for (int i = 1; i < nlistas; i++) if (listas[i]->total < base->total) base = listas[i];
+        int limite = base->total < LIMITE_CANDIDATOS_BUSCA ? base->total : LIMITE_CANDIDATOS_BUSCA;
+        for (int k = 0; k < limite; k++) {
+            int id = base->ids[k];
+            int pos = posicaoSemCaixa(cursos[id].nome, q, qlen);
+            if (pos < 0 || (qlen < 3 && pos != 0)) continue;
+            int classe = (pos == 0) ? 3 : (!isalnum((unsigned char)cursos[id].nome[pos - 1]) ? 2 : 1);
+            long pontuacao = classe * 1000000L - pos * 1000L - (long)(strlen(cursos[id].nome) - qlen) * 10 + cursos[id].prioridade;
+            inserirResultado(res, &n, max, id, pontuacao);
+        }
+    }
+
+    if (n < max && qlen >= 3 && nlistas >= 2) {
+        garantirContadoresBusca();
+        if (++epoca_atual == 0) {
+            memset(epoca_busca, 0, capacidade_busca * sizeof(unsigned));
+            epoca_atual = 1;
+        }
+        // Conta os trigramas em comum percorrendo as listas menores primeiro
+        int orcamento = LIMITE_POSTAGENS_APROXIMADA;
+        int candidatos[MAX_RESULTADOS_BUSCA * 8];
+        int total_candidatos = 0;
+        int minimo = (nchaves + 1) / 2;
+        for (int usadas = 0; usadas < nlistas; usadas++) {
+            Postagem* p = NULL;
+            for (int i = 0; i < nlistas; i++) {
+                if (listas[i] && (!p || listas[i]->total < p->total)) p = listas[i];
+            }
+            for (int i = 0; i < nlistas; i++) if (listas[i] == p) listas[i] = NULL;
+            if (p->total > orcamento) break;
+            orcamento -= p->total;
+            for (int k = 0; k < p->total; k++) {
+                int id = p->ids[k];
+                if (epoca_busca[id] != epoca_atual) {
+                    epoca_busca[id] = epoca_atual;
+                    contagem_busca[id] = 0;
+                }
+                if (++contagem_busca[id] == minimo && total_candidatos < (int)(sizeof(candidatos) / sizeof(int))) {
+                    candidatos[total_candidatos++] = id;
+                }
+            }
+        }
+        for (int i = 0; i < total_candidatos; i++) {
+            int id = candidatos[i];
+            // As correspondências exatas já foram pontuadas acima
+            if (posicaoSemCaixa(cursos[id].nome, q, qlen) >= 0) continue;
+            long pontuacao = contagem_busca[id] * 1000L - labs((long)strlen(cursos[id].nome) - qlen) * 10 + cursos[id].prioridade;
+            inserirResultado(res, &n, max, id, pontuacao);
+        }
+    }
+    return n;
+}
+
+// Busca exata pelo nome no índice de nomes; -1 se não existir. Só então a
+// busca ranqueada (limitada) monta as sugestões de "você quis dizer".
+int localizarCursoPorNome(const char* nome, ResultadoBusca* sugestoes, int* total_sugestoes) {
+    int id = buscarCursoExato(nome);
+    if (id >= 0 || !sugestoes) return id;
+    ResultadoBusca res[MAX_RESULTADOS_BUSCA];
+    int n = buscarCursosPorNome(nome, res, MAX_RESULTADOS_BUSCA);
+    *total_sugestoes = n < 3 ? n : 3;
+    memcpy(sugestoes, res, *total_sugestoes * sizeof(ResultadoBusca));
+    return -1;
+}
+
 void carregarCursos() {
     FILE* arquivo = fopen("cursos.txt", "r");
     if (!arquivo) {
@@ -282,8 +606,13 @@ void carregarCursos() {
     char linha[256];
     while (fgets(linha, sizeof(linha), arquivo)) {
         if (num_cursos >= capacidade_cursos) expandirCursos();
-        sscanf(linha, "%[^,],%d,%d", cursos[num_cursos].nome, &cursos[num_cursos].duracao, &cursos[num_cursos].prioridade);
+        Curso* c = &cursos[num_cursos];
+        // A coluna de vagas é opcional para manter compatibilidade com arquivos antigos
+        if (sscanf(linha, "%[^,],%d,%d,%d", c->nome, &c->duracao, &c->prioridade, &c->vagas) < 4) c->vagas = 0;
+        c->ocupadas = 0;
+        c->em_espera = 0;
         num_cursos++;
+        indexarCurso(num_cursos - 1);
     }
     fclose(arquivo);
 }
@@ -295,7 +624,7 @@ void salvarCursos() {
         return;
     }
     for (int i = 0; i < num_cursos; i++) {
-        fprintf(arquivo, "%s,%d,%d\n", cursos[i].nome, cursos[i].duracao, cursos[i].prioridade);
+        fprintf(arquivo, "%s,%d,%d,%d\n", cursos[i].nome, cursos[i].duracao, cursos[i].prioridade, cursos[i].vagas);
     }
     fclose(arquivo);
 }
@@ -335,7 +664,13 @@ void adicionarCurso() {
     scanf("%d", &cursos[num_cursos].duracao);
     printf("Prioridade (1-10): ");
     scanf("%d", &cursos[num_cursos].prioridade);
+    printf("Vagas (0 = sem limite): ");
+    scanf("%d", &cursos[num_cursos].vagas);
+    if (cursos[num_cursos].vagas < 0) cursos[num_cursos].vagas = 0;
+    cursos[num_cursos].ocupadas = 0;
+    cursos[num_cursos].em_espera = 0;
     num_cursos++;
+    indexarCurso(num_cursos - 1);
     printf("Curso adicionado.\n");
 }
 
@@ -360,16 +695,25 @@ void inscreverAluno(Fila* fila, Pilha* historico) {
     printf("Nome do curso: ");
     char nome_curso[MAX_NOME];
     scanf(" %[^\n]", nome_curso);
-    for (index_curso = 0; index_curso < num_cursos; index_curso++) {
-        if (strcmp(cursos[index_curso].nome, nome_curso) == 0) break;
-    }
-    if (index_curso == num_cursos) {
+    ResultadoBusca sugestoes[3];
+    int total_sugestoes = 0;
+    index_curso = localizarCursoPorNome(nome_curso, sugestoes, &total_sugestoes);
+    if (index_curso == -1) {
         printf("Erro: Curso não encontrado.\n");
+        for (int i = 0; i < total_sugestoes; i++) {
+            printf("  Você quis dizer: %s?\n", cursos[sugestoes[i].id].nome);
+        }
         return;
     }
+    int prioridade;
+    printf("Prioridade da inscrição (1-%d): ", PRIORIDADES_INSCRICAO);
+    if (scanf("%d", &prioridade) != 1) prioridade = 1;
+    if (prioridade < 1) prioridade = 1;
+    if (prioridade > PRIORIDADES_INSCRICAO) prioridade = PRIORIDADES_INSCRICAO;
     Inscricao nova;
     nova.aluno = alunos[aluno_index];
     nova.curso_index = index_curso;
+    nova.prioridade = prioridade;
     nova.timestamp = time(NULL);
     enfileirar(fila, nova);
     char acao[100];
@@ -378,21 +722,219 @@ void inscreverAluno(Fila* fila, Pilha* historico) {
     printf("Inscrição realizada.\n");
 }
 
+// Ocupa uma vaga do curso ou, se estiver lotado, coloca a inscrição na lista de espera
+int ocuparVaga(Inscricao* inscricao) {
+    Curso* c = &cursos[inscricao->curso_index];
+    if (c->vagas == 0 || c->ocupadas < c->vagas) {
+        c->ocupadas++;
+        return 1;
+    }
+    c->em_espera++;
+    enfileirar(&lista_espera, *inscricao);
+    return 0;
+}
+
+// Posição da inscrição entre as prioridades: 0 para a maior
+int nivelPrioridade(const Inscricao* inscricao) {
+    int prioridade = inscricao->prioridade;
+    if (prioridade < 1) prioridade = 1;
+    if (prioridade > PRIORIDADES_INSCRICAO) prioridade = PRIORIDADES_INSCRICAO;
+    return PRIORIDADES_INSCRICAO - prioridade;
+}
+
+size_t baldeInscricao(const Inscricao* inscricao) {
+    return (size_t)inscricao->curso_index * PRIORIDADES_INSCRICAO + nivelPrioridade(inscricao);
+}
+
+// Põe a fila em ordem decrescente de prioridade, mantendo a ordem de chegada
+// entre as de mesma prioridade (counting sort estável que só religa os nós).
+// Assim o atendimento um a um segue a mesma ordem da alocação em lote.
+void ordenarFilaPorPrioridade(Fila* fila) {
+    if (!fila->desordenada) return;
+    NoFila* frentes[PRIORIDADES_INSCRICAO] = { NULL };
+    NoFila* trases[PRIORIDADES_INSCRICAO] = { NULL };
+    for (NoFila* no = fila->frente; no; no = no->proximo) {
+        int b = nivelPrioridade(&no->inscricao);
+        if (trases[b]) trases[b]->proximo = no;
+        else frentes[b] = no;
+        trases[b] = no;
+    }
+    fila->frente = fila->tras = NULL;
+    for (int b = 0; b < PRIORIDADES_INSCRICAO; b++) {
+        if (!frentes[b]) continue;
+        if (fila->tras) fila->tras->proximo = frentes[b];
+        else fila->frente = frentes[b];
+        fila->tras = trases[b];
+    }
+    fila->tras->proximo = NULL;
+    fila->desordenada = 0;
+}
+
+// Atende uma inscrição já retirada da fila: ocupa a vaga ou a põe na lista
+// de espera e registra a ação no histórico. 'mostrar' imprime o resultado
+// (o processamento em segundo plano roda em silêncio).
+void atenderInscricao(Inscricao* inscricao, Pilha* historico, int mostrar) {
+    const char* curso = cursos[inscricao->curso_index].nome;
+    int matriculado = ocuparVaga(inscricao);
+    if (mostrar && matriculado) {
+        printf("Processando inscrição: %s em %s\n", inscricao->aluno.nome, curso);
+    } else if (mostrar) {
+        printf("Curso %s lotado: %s entrou na lista de espera (posição %d).\n",
+               curso, inscricao->aluno.nome, cursos[inscricao->curso_index].em_espera);
+    }
+    char acao[2 * MAX_NOME + 20]; // rótulo + nome do aluno + nome do curso
+    snprintf(acao, sizeof(acao), "%s: %s em %s", matriculado ? "Processamento" : "Espera", inscricao->aluno.nome, curso);
+    empilhar(historico, acao);
+}
+
 void processarInscricao(Fila* fila, Pilha* historico) {
     if (filaVazia(fila)) {
         printf("Nenhuma inscrição para processar.\n");
         return;
     }
+    ordenarFilaPorPrioridade(fila);
     Inscricao processada = desenfileirar(fila);
-    printf("Processando inscrição: %s em %s\n", processada.aluno.nome, cursos[processada.curso_index].nome);
+    atenderInscricao(&processada, historico, 1);
+}
+
+// Aloca todas as inscrições pendentes de uma vez. As inscrições são
+// distribuídas por counting sort em baldes (curso, prioridade decrescente),
+// o que preserva a ordem de chegada dentro de cada balde; depois cada curso
+// preenche suas vagas na ordem dos baldes e o excedente vai para a lista de
+// espera. Custo O(inscrições + cursos), sem realocar os nós da fila.
+// Retorna o número de matrículas ou -1 se faltar memória (fila intacta).
+long alocarInscricoesEmLote(Fila* fila, long* em_espera) {
+    long n = fila->tamanho;
+    *em_espera = 0;
+    if (n == 0) return 0;
+    size_t baldes = (size_t)num_cursos * PRIORIDADES_INSCRICAO;
+    long* inicio = (long*)calloc(baldes + 1, sizeof(long));
+    NoFila** ordenados = (NoFila**)malloc(n * sizeof(NoFila*));
+    if (!inicio || !ordenados) {
+        printf("Erro: Falha na alocação para a alocação em lote.\n");
+        free(inicio);
+        free(ordenados);
+        return -1;
+    }
+    for (NoFila* no = fila->frente; no; no = no->proximo) inicio[baldeInscricao(&no->inscricao) + 1]++;
+    for (size_t b = 1; b <= baldes; b++) inicio[b] += inicio[b - 1];
+    for (NoFila* no = fila->frente; no; no = no->proximo) ordenados[inicio[baldeInscricao(&no->inscricao)]++] = no;
+
+    long matriculados = 0;
+    for (long i = 0; i < n; i++) {
+        NoFila* no = ordenados[i];
+        Curso* c = &cursos[no->inscricao.curso_index];
+        if (c->vagas == 0 || c->ocupadas < c->vagas) {
+            c->ocupadas++;
+            matriculados++;
+            free(no);
+        } else {
+            // O nó é reaproveitado na lista de espera
+            c->em_espera++;
+            no->proximo = NULL;
+            if (filaVazia(&lista_espera)) lista_espera.frente = no;
+            else lista_espera.tras->proximo = no;
+            lista_espera.tras = no;
+            lista_espera.tamanho++;
+            (*em_espera)++;
+        }
+    }
+    fila->frente = fila->tras = NULL;
+    fila->tamanho = 0;
+    fila->desordenada = 0;
+    free(inicio);
+    free(ordenados);
+    return matriculados;
+}
+
+void alocarVagasEmLote(Fila* fila, Pilha* historico) {
+    if (filaVazia(fila)) {
+        printf("Nenhuma inscrição para alocar.\n");
+        return;
+    }
+    long pedidos = fila->tamanho;
+    long em_espera;
+    long matriculados = alocarInscricoesEmLote(fila, &em_espera);
+    if (matriculados < 0) return;
+    printf("Alocação concluída: %ld pedidos, %ld matrículas, %ld na lista de espera.\n", pedidos, matriculados, em_espera);
+    int mostrados = 0;
+    for (int i = 0; i < num_cursos && mostrados < 10; i++) {
+        if (cursos[i].em_espera == 0) continue;
+        printf("  %s: %d/%d vagas, %d em espera\n", cursos[i].nome, cursos[i].ocupadas, cursos[i].vagas, cursos[i].em_espera);
+        mostrados++;
+    }
     char acao[100];
-    snprintf(acao, sizeof(acao), "Processamento: %s em %s", processada.aluno.nome, cursos[processada.curso_index].nome);
+    snprintf(acao, sizeof(acao), "Alocação em lote: %ld matrículas", matriculados);
     empilhar(historico, acao);
 }
 
+long agoraUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+// Processa inscrições pendentes em silêncio até esgotar a fila ou o orçamento
+// de tempo. As pendentes competem pelas vagas por prioridade, como na
+// alocação em lote.
+int processarLote(Fila* fila, Pilha* historico, long orcamento_us) {
+    long inicio = agoraUs();
+    int processadas = 0;
+    ordenarFilaPorPrioridade(fila);
+    while (!filaVazia(fila) && agoraUs() - inicio < orcamento_us) {
+        Inscricao processada = desenfileirar(fila);
+        atenderInscricao(&processada, historico, 0);
+        processadas++;
+    }
+    inscricoes_processadas_fundo += processadas;
+    return processadas;
+}
+
+// Loop de eventos do menu: espera uma tecla com poll() e, enquanto o operador
+// está parado, processa a fila em fatias de FATIA_PROCESSAMENTO_US. Retorna
+// TECLA_ATUALIZAR quando o status mudou e o menu precisa ser redesenhado.
+int capturaTecla(Fila* fila, Pilha* historico) {
+    struct termios oldt, newt;
+    struct pollfd entrada = { STDIN_FILENO, POLLIN, 0 };
+    unsigned char c;
+    int ch = TECLA_ATUALIZAR;
+    int alterado = 0;
+    long ultimo_status = agoraUs();
+    tcgetattr(STDIN_FILENO, &oldt);
+    newt = oldt;
+    newt.c_lflag &= ~(ICANON | ECHO);
+    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+    while (1) {
+        int espera = filaVazia(fila) ? -1 : 0;
+        if (poll(&entrada, 1, espera) > 0) {
+            ch = (read(STDIN_FILENO, &c, 1) == 1) ? c : EOF;
+            break;
+        }
+        if (processarLote(fila, historico, FATIA_PROCESSAMENTO_US) > 0) alterado = 1;
+        if (alterado && (filaVazia(fila) || agoraUs() - ultimo_status >= INTERVALO_STATUS_MS * 1000L)) {
+            break;
+        }
+    }
+    if (ch == 27) {
+        unsigned char seq[2] = {0, 0};
+        if (poll(&entrada, 1, 30) > 0 && read(STDIN_FILENO, &seq[0], 1) == 1 &&
+            poll(&entrada, 1, 30) > 0 && read(STDIN_FILENO, &seq[1], 1) == 1) {
+            if (seq[1] == 'A') ch = 'w';
+            else if (seq[1] == 'B') ch = 's';
+            else ch = TECLA_ATUALIZAR;
+        } else {
+            ch = TECLA_ATUALIZAR;
+        }
+    }
+    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    return ch;
+}
+
 void ordenarCursos() {
-    if (num_cursos > 0)
+    if (num_cursos > 0) {
         quickSort(cursos, 0, num_cursos - 1);
+        reconstruirIndiceCursos();
+    }
     printf("Cursos ordenados por prioridade.\n");
 }
 
@@ -408,6 +950,47 @@ void buscarCurso() {
     }
 }
 
+// Busca interativa: a lista é refeita a cada tecla digitada
+void buscarCursoPorNome(Fila* fila, Pilha* historico) {
+    char consulta[MAX_NOME] = "";
+    int len = 0;
+    ResultadoBusca res[MAX_RESULTADOS_BUSCA];
+    while (1) {
+        long inicio = agoraUs();
+        int n = buscarCursosPorNome(consulta, res, MAX_RESULTADOS_BUSCA);
+        long duracao = agoraUs() - inicio;
+
+        system("clear");
+        print_border_top();
+        print_line("Buscar Curso por Nome (prefixo ou trecho)");
+        print_line("");
+        char linha[120];
+        snprintf(linha, sizeof(linha), "Busca: %s_", consulta);
+        print_line(linha);
+        print_line("");
+        for (int i = 0; i < n; i++) {
+            snprintf(linha, sizeof(linha), " %s (%dh, prioridade %d)", cursos[res[i].id].nome, cursos[res[i].id].duracao, cursos[res[i].id].prioridade);
+            print_line(linha);
+        }
+        print_line("");
+        snprintf(linha, sizeof(linha), "%d resultado(s) em %ld us", n, duracao);
+        print_line(linha);
+        print_line("Digite para filtrar, Backspace apaga, Enter volta.");
+        print_border_bottom();
+
+        int tecla = capturaTecla(fila, historico);
+        if (tecla == EOF || tecla == '\n' || tecla == '\r') break;
+        if (tecla == 127 || tecla == 8) {
+            // Remove o último caractere inteiro, mesmo que seja multibyte
+            while (len > 0 && ((unsigned char)consulta[--len] & 0xC0) == 0x80);
+            consulta[len] = '\0';
+        } else if (tecla >= 32 && len < MAX_NOME - 1) {
+            consulta[len++] = (char)tecla;
+            consulta[len] = '\0';
+        }
+    }
+}
+
 void undo(Pilha* historico) {
     char* acao = desempilhar(historico);
     if (acao) {
@@ -434,12 +1017,14 @@ int main() {
         "Adicionar Aluno",
         "Inscrever Aluno em Curso",
         "Processar Inscrição",
+        "Alocar Vagas em Lote",
         "Ordenar Cursos por Prioridade",
         "Buscar Curso por Prioridade",
+        "Buscar Curso por Nome",
         "Undo Última Ação",
         "Sair"
     };
-    int total_opcoes = 8;
+    int total_opcoes = 10;
     int selected = 0;
     int running = 1;
 
@@ -457,10 +1042,19 @@ int main() {
             print_line(buffer);
         }
         print_line("");
+        char status[100];
+        snprintf(status, sizeof(status), "Fila: %d | Espera: %d | Em 2º plano: %ld",
+                 fila_inscricoes.tamanho, lista_espera.tamanho, inscricoes_processadas_fundo);
+        print_line(status);
         print_line("Use as setas ou W/S para navegar, Enter para selecionar.");
         print_border_bottom();
 
-        int tecla = capturaTecla();
+        int tecla = capturaTecla(&fila_inscricoes, &historico);
+        if (tecla == EOF) {
+            // Entrada encerrada: sai salvando, como na opção "Sair"
+            selected = total_opcoes - 1;
+            tecla = '\n';
+        }
 
         if (tecla == 'w') {
             selected = (selected - 1 + total_opcoes) % total_opcoes;
@@ -485,18 +1079,25 @@ int main() {
                     esperarPressionarQ();
                     break;
                 case 4:
-                    ordenarCursos();
+                    alocarVagasEmLote(&fila_inscricoes, &historico);
                     esperarPressionarQ();
                     break;
                 case 5:
-                    buscarCurso();
+                    ordenarCursos();
                     esperarPressionarQ();
                     break;
                 case 6:
-                    undo(&historico);
+                    buscarCurso();
                     esperarPressionarQ();
                     break;
                 case 7:
+                    buscarCursoPorNome(&fila_inscricoes, &historico);
+                    break;
+                case 8:
+                    undo(&historico);
+                    esperarPressionarQ();
+                    break;
+                case 9:
                     salvarCursos();
                     salvarAlunos();
 
@@ -508,6 +1109,14 @@ int main() {
                     fila_inscricoes.tras = NULL;
                     fila_inscricoes.tamanho = 0;
 
+                    while (lista_espera.frente != NULL) {
+                        NoFila* tmp = lista_espera.frente;
+                        lista_espera.frente = tmp->proximo;
+                        free(tmp);
+                    }
+                    lista_espera.tras = NULL;
+                    lista_espera.tamanho = 0;
+
                     while (historico.topo != NULL) {
                         NoPilha* tmp = historico.topo;
                         historico.topo = tmp->proximo;
@@ -515,6 +1124,7 @@ int main() {
                     }
                     historico.tamanho = 0;
 
+                    liberarIndiceCursos();
                     if (cursos) {
                         free(cursos);
                         cursos = NULL;
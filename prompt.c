@@ -29,6 +29,24 @@ typedef struct {
     time_t timestamp; // para ordenação por tempo de chegada
 } Inscricao;
 
+#define MAX_ACAO 100
+#define MAX_HISTORICO 256
+
+#ifdef PERFIL_ESTATICO
+// TAD: Fila (buffer circular de tamanho fixo, sem uso do heap)
+typedef struct {
+    Inscricao itens[MAX_INSCRICOES];
+    int frente; // índice do primeiro elemento
+    int tamanho;
+} Fila;
+
+// TAD: Pilha (array fixo circular; ao encher, descarta a ação mais antiga)
+typedef struct {
+    char acoes[MAX_HISTORICO][MAX_ACAO];
+    int base; // índice da ação mais antiga
+    int tamanho;
+} Pilha;
+#else
 // TAD: Fila (usando lista ligada para eficiência em inserções/removências)
 typedef struct NoFila {
     Inscricao inscricao;
@@ -43,7 +61,7 @@ typedef struct {
 
 // TAD: Pilha (usando lista ligada para eficiência)
 typedef struct NoPilha {
-    char acao[MAX_NOME]; // descrição da ação para undo
+    char acao[MAX_ACAO]; // descrição da ação para undo
     struct NoPilha* proximo;
 } NoPilha;
 
@@ -51,6 +69,7 @@ typedef struct {
     NoPilha* topo;
     int tamanho;
 } Pilha;
+#endif
 
 // Arrays globais para cursos e alunos (para busca e ordenação)
 Curso cursos[MAX_CURSOS];
@@ -58,6 +77,77 @@ int num_cursos = 0;
 Aluno alunos[MAX_ALUNOS];
 int num_alunos = 0;
 
+#ifdef PERFIL_ESTATICO
+// Funções para Fila (perfil estático: O(1), sem malloc)
+void inicializarFila(Fila* f) {
+    f->frente = 0;
+    f->tamanho = 0;
+}
+
+int filaVazia(Fila* f) {
+    return f->tamanho == 0;
+}
+
+int filaCheia(Fila* f) {
+    return f->tamanho == MAX_INSCRICOES;
+}
+
+// Retorna 1 se enfileirou, 0 se a fila está cheia
+int enfileirar(Fila* f, Inscricao inscricao) {
+    if (filaCheia(f)) {
+        printf("Erro: Fila de inscrições cheia (%d).\n", MAX_INSCRICOES);
+        return 0;
+    }
+    f->itens[(f->frente + f->tamanho) % MAX_INSCRICOES] = inscricao;
+    f->tamanho++;
+    return 1;
+}
+
+Inscricao desenfileirar(Fila* f) {
+    if (filaVazia(f)) {
+        printf("Erro: Fila vazia.\n");
+        exit(1);
+    }
+    Inscricao inscricao = f->itens[f->frente];
+    f->frente = (f->frente + 1) % MAX_INSCRICOES;
+    f->tamanho--;
+    return inscricao;
+}
+
+// Funções para Pilha (perfil estático)
+void inicializarPilha(Pilha* p) {
+    p->base = 0;
+    p->tamanho = 0;
+}
+
+int pilhaVazia(Pilha* p) {
+    return p->tamanho == 0;
+}
+
+void empilhar(Pilha* p, const char* acao) {
+    if (p->tamanho == MAX_HISTORICO) {
+        // Overflow: descarta a ação mais antiga para manter as recentes
+        printf("Aviso: Histórico cheio, ação mais antiga descartada.\n");
+        p->base = (p->base + 1) % MAX_HISTORICO;
+        p->tamanho--;
+    }
+    char* destino = p->acoes[(p->base + p->tamanho) % MAX_HISTORICO];
+    strncpy(destino, acao, MAX_ACAO - 1);
+    destino[MAX_ACAO - 1] = '\0';
+    p->tamanho++;
+}
+
+// Copia a ação do topo para 'acao' (MAX_ACAO bytes). Retorna 0 se vazia.
+int desempilhar(Pilha* p, char* acao) {
+    if (pilhaVazia(p)) {
+        printf("Erro: Pilha vazia.\n");
+        return 0;
+    }
+    p->tamanho--;
+    strcpy(acao, p->acoes[(p->base + p->tamanho) % MAX_HISTORICO]);
+    return 1;
+}
+#else
 // Funções para Fila
 void inicializarFila(Fila* f) {
     f->frente = NULL;
@@ -69,11 +159,12 @@ int filaVazia(Fila* f) {
     return f->tamanho == 0;
 }
 
-void enfileirar(Fila* f, Inscricao inscricao) {
+// Retorna 1 se enfileirou, 0 em falha de alocação
+int enfileirar(Fila* f, Inscricao inscricao) {
     NoFila* novo = (NoFila*)malloc(sizeof(NoFila));
     if (!novo) {
         printf("Erro: Falha na alocação de memória.\n");
-        return;
+        return 0;
     }
     novo->inscricao = inscricao;
     novo->proximo = NULL;
@@ -84,6 +175,7 @@ void enfileirar(Fila* f, Inscricao inscricao) {
         f->tras = novo;
     }
     f->tamanho++;
+    return 1;
 }
 
 Inscricao desenfileirar(Fila* f) {
@@ -116,25 +208,27 @@ void empilhar(Pilha* p, const char* acao) {
         printf("Erro: Falha na alocação de memória.\n");
         return;
     }
-    strcpy(novo->acao, acao);
+    strncpy(novo->acao, acao, MAX_ACAO - 1);
+    novo->acao[MAX_ACAO - 1] = '\0';
     novo->proximo = p->topo;
     p->topo = novo;
     p->tamanho++;
 }
 
-char* desempilhar(Pilha* p) {
+// Copia a ação do topo para 'acao' (MAX_ACAO bytes). Retorna 0 se vazia.
+int desempilhar(Pilha* p, char* acao) {
     if (pilhaVazia(p)) {
         printf("Erro: Pilha vazia.\n");
-        return NULL;
+        return 0;
     }
     NoPilha* temp = p->topo;
-    char* acao = (char*)malloc(strlen(temp->acao) + 1);
     strcpy(acao, temp->acao);
     p->topo = p->topo->proximo;
     free(temp);
     p->tamanho--;
-    return acao;
+    return 1;
 }
+#endif
 
 // Algoritmo de Ordenação: QuickSort para cursos por prioridade (otimizado)
 void trocar(Curso* a, Curso* b) {
@@ -238,9 +332,12 @@ void inscreverAluno(Fila* fila, Pilha* historico) {
     nova.aluno = alunos[aluno_index];
     nova.curso_index = index_curso;
     nova.timestamp = time(NULL);
-    enfileirar(fila, nova);
-    char acao[100];
-    sprintf(acao, "Inscrição: %s em %s", alunos[aluno_index].nome, cursos[index_curso].nome);
+    if (!enfileirar(fila, nova)) {
+        printf("Erro: Inscrição não realizada.\n");
+        return;
+    }
+    char acao[MAX_ACAO];
+    snprintf(acao, sizeof(acao), "Inscrição: %s em %s", alunos[aluno_index].nome, cursos[index_curso].nome);
     empilhar(historico, acao);
     printf("Inscrição realizada.\n");
 }
@@ -253,8 +350,8 @@ void processarInscricao(Fila* fila, Pilha* historico) {
     }
     Inscricao processada = desenfileirar(fila);
     printf("Processando inscrição: %s em %s\n", processada.aluno.nome, cursos[processada.curso_index].nome);
-    char acao[100];
-    sprintf(acao, "Processamento: %s em %s", processada.aluno.nome, cursos[processada.curso_index].nome);
+    char acao[MAX_ACAO];
+    snprintf(acao, sizeof(acao), "Processamento: %s em %s", processada.aluno.nome, cursos[processada.curso_index].nome);
     empilhar(historico, acao);
 }
 
@@ -279,10 +376,9 @@ void buscarCurso() {
 
 // Função para undo (usando pilha)
 void undo(Pilha* historico) {
-    char* acao = desempilhar(historico);
-    if (acao) {
+    char acao[MAX_ACAO];
+    if (!pilhaVazia(historico) && desempilhar(historico, acao)) {
         printf("Undo: %s\n", acao);
-        free(acao);
     } else {
         printf("Nenhuma ação para desfazer.\n");
     }
@@ -290,8 +386,14 @@ void undo(Pilha* historico) {
 
 // Menu principal
 int main() {
+#ifdef PERFIL_ESTATICO
+    // Estáticas para não depender do tamanho da stack no kiosk embarcado
+    static Fila fila_inscricoes;
+    static Pilha historico;
+#else
     Fila fila_inscricoes;
     Pilha historico;
+#endif
     inicializarFila(&fila_inscricoes);
     inicializarPilha(&historico);
 
@@ -324,7 +426,8 @@ int main() {
 
     // Liberar memória (otimização: evitar vazamentos)
     while (!filaVazia(&fila_inscricoes)) desenfileirar(&fila_inscricoes);
-    while (!pilhaVazia(&historico)) free(desempilhar(&historico));
+    char descartada[MAX_ACAO];
+    while (!pilhaVazia(&historico)) desempilhar(&historico, descartada);
 
     return 0;
 }
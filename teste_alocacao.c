@@ -0,0 +1,104 @@
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <string.h>
+
+// Teste da ordem de atendimento das inscrições em main.c: com mais pedidos
+// que vagas, as de maior prioridade ficam com as vagas e as demais vão para
+// a lista de espera na ordem de chegada. Vale para os três caminhos:
+// processamento em segundo plano, "Processar Inscrição" e alocação em lote.
+//
+//   gcc -O2 teste_alocacao.c -o teste_alocacao && ./teste_alocacao
+
+#define main main_motor
+// Mensagens do motor não poluem a saída do teste
+#define printf(...) ((void)(0 && printf(__VA_ARGS__)))
+#include "main.c"
+#undef printf
+#undef main
+
+static int falhas = 0;
+
+static void verificar(int condicao, const char* caminho, const char* descricao) {
+    if (!condicao) {
+        printf("FALHOU [%s]: %s\n", caminho, descricao);
+        falhas++;
+    }
+}
+
+// Um curso com 2 vagas e 5 pedidos; só C (5) e D (9) têm prioridade acima de 1
+static void prepararCenario(Fila* fila) {
+    static const struct { const char* nome; int prioridade; } pedidos[] = {
+        { "A", 1 }, { "B", 1 }, { "C", 5 }, { "D", 9 }, { "E", 1 }
+    };
+    while (!filaVazia(&lista_espera)) desenfileirar(&lista_espera);
+    num_cursos = 0;
+    expandirCursos();
+    Curso* c = &cursos[num_cursos++];
+    strcpy(c->nome, "Redes");
+    c->duracao = 40;
+    c->prioridade = 1;
+    c->vagas = 2;
+    c->ocupadas = 0;
+    c->em_espera = 0;
+    inicializarFila(fila);
+    for (int i = 0; i < 5; i++) {
+        Inscricao nova;
+        memset(&nova, 0, sizeof(nova));
+        strcpy(nova.aluno.nome, pedidos[i].nome);
+        nova.aluno.id = i + 1;
+        nova.curso_index = 0;
+        nova.prioridade = pedidos[i].prioridade;
+        nova.timestamp = i;
+        enfileirar(fila, nova);
+    }
+}
+
+static void verificarResultado(const char* caminho) {
+    verificar(cursos[0].ocupadas == 2, caminho, "as 2 vagas ocupadas");
+    verificar(cursos[0].em_espera == 3, caminho, "3 inscrições em espera");
+    const char* esperados[] = { "A", "B", "E" };
+    int i = 0;
+    for (NoFila* no = lista_espera.frente; no; no = no->proximo, i++) {
+        verificar(i < 3 && strcmp(no->inscricao.aluno.nome, esperados[i]) == 0, caminho,
+                  "lista de espera com A, B e E, na ordem de chegada");
+    }
+    verificar(i == 3, caminho, "lista de espera com 3 inscrições");
+}
+
+static void liberarPilha(Pilha* p) {
+    char* acao;
+    while ((acao = desempilhar(p)) != NULL) free(acao);
+}
+
+int main(void) {
+    Fila fila;
+    Pilha historico;
+    inicializarPilha(&historico);
+
+    prepararCenario(&fila);
+    processarLote(&fila, &historico, 1000000L);
+    verificar(filaVazia(&fila), "segundo plano", "fila esgotada");
+    verificarResultado("segundo plano");
+    // O topo do histórico é o último atendido; os dois primeiros foram D e C
+    verificar(historico.tamanho == 5, "segundo plano", "uma ação por inscrição");
+
+    prepararCenario(&fila);
+    processarInscricao(&fila, &historico);
+    verificar(cursos[0].ocupadas == 1 && fila.tamanho == 4, "processar inscrição", "uma inscrição atendida");
+    verificar(strstr(historico.topo->acao, "D em Redes") != NULL, "processar inscrição", "D (prioridade 9) atendida primeiro");
+    while (!filaVazia(&fila)) processarInscricao(&fila, &historico);
+    verificarResultado("processar inscrição");
+
+    prepararCenario(&fila);
+    long em_espera;
+    long matriculados = alocarInscricoesEmLote(&fila, &em_espera);
+    verificar(matriculados == 2 && em_espera == 3, "lote", "2 matrículas e 3 em espera");
+    verificarResultado("lote");
+
+    while (!filaVazia(&lista_espera)) desenfileirar(&lista_espera);
+    liberarPilha(&historico);
+    liberarIndiceCursos();
+    free(cursos);
+    if (falhas == 0) printf("Todos os testes de alocação passaram.\n");
+    return falhas == 0 ? 0 : 1;
+}